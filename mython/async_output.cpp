@@ -0,0 +1,169 @@
+#include "async_output.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        size_t RoundUpToPowerOfTwo(size_t value) {
+            size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+    }  // namespace
+
+    AsyncOutputBuffer::AsyncOutputBuffer(ostream& target, size_t capacity)
+        : target_(target)
+        , ring_(RoundUpToPowerOfTwo(max<size_t>(capacity, 16)))
+        , mask_(ring_.size() - 1) {
+        setp(pending_.data(), pending_.data() + pending_.size());
+        writer_ = thread([this] {
+            RunWriter();
+        });
+    }
+
+    AsyncOutputBuffer::~AsyncOutputBuffer() {
+        Flush();
+        {
+            lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        data_ready_.notify_one();
+        writer_.join();
+    }
+
+    void AsyncOutputBuffer::Flush() {
+        PublishPending();
+        const size_t head = head_.load(memory_order_relaxed);
+        if (flushed_.load(memory_order_acquire) == head)
+        {
+            return;
+        }
+        unique_lock lock(mutex_);
+        producer_waiting_.store(true);
+        space_ready_.wait(lock, [this, head] {
+            return flushed_.load() == head;
+        });
+        producer_waiting_.store(false);
+    }
+
+    AsyncOutputBuffer::int_type AsyncOutputBuffer::overflow(int_type ch) {
+        PublishPending();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    streamsize AsyncOutputBuffer::xsputn(const char* s, streamsize count) {
+        const auto size = static_cast<size_t>(count);
+        if (size <= static_cast<size_t>(epptr() - pptr()))
+        {
+            memcpy(pptr(), s, size);
+            pbump(static_cast<int>(count));
+            return count;
+        }
+        PublishPending();
+        Push(s, size);
+        return count;
+    }
+
+    int AsyncOutputBuffer::sync() {
+        PublishPending();
+        return 0;
+    }
+
+    void AsyncOutputBuffer::PublishPending() {
+        if (pptr() != pbase())
+        {
+            Push(pbase(), static_cast<size_t>(pptr() - pbase()));
+            setp(pending_.data(), pending_.data() + pending_.size());
+        }
+    }
+
+    void AsyncOutputBuffer::Push(const char* data, size_t size) {
+        size_t head = head_.load(memory_order_relaxed);
+        while (size > 0)
+        {
+            size_t free = ring_.size() - (head - tail_.load(memory_order_acquire));
+            if (free == 0)
+            {
+                // Буфер заполнен: ждём, пока поток записи не заберёт часть данных
+                unique_lock lock(mutex_);
+                producer_waiting_.store(true);
+                space_ready_.wait(lock, [this, head] {
+                    return tail_.load() != head - ring_.size();
+                });
+                producer_waiting_.store(false);
+                continue;
+            }
+
+            const size_t offset = head & mask_;
+            const size_t chunk = min({size, free, ring_.size() - offset});
+            memcpy(ring_.data() + offset, data, chunk);
+            data += chunk;
+            size -= chunk;
+            head += chunk;
+            head_.store(head);
+            // Сохранение head_ и чтение флага упорядочены, поэтому либо поток записи увидит
+            // новые данные перед сном, либо здесь будет видно, что его нужно разбудить
+            if (writer_waiting_.load())
+            {
+                lock_guard lock(mutex_);
+                data_ready_.notify_one();
+            }
+        }
+    }
+
+    void AsyncOutputBuffer::RunWriter() {
+        size_t tail = 0;
+        while (true)
+        {
+            size_t head = head_.load(memory_order_acquire);
+            if (head == tail)
+            {
+                // Все данные записаны: сбрасываем target и ждём новых данных
+                target_.flush();
+                flushed_.store(tail);
+                unique_lock lock(mutex_);
+                if (producer_waiting_.load())
+                {
+                    space_ready_.notify_one();
+                }
+                writer_waiting_.store(true);
+                data_ready_.wait(lock, [this, tail] {
+                    return head_.load() != tail || stop_;
+                });
+                writer_waiting_.store(false);
+                if (head_.load() == tail)
+                {
+                    return;
+                }
+                continue;
+            }
+
+            while (tail != head)
+            {
+                const size_t offset = tail & mask_;
+                const size_t chunk = min(head - tail, ring_.size() - offset);
+                target_.write(ring_.data() + offset, static_cast<streamsize>(chunk));
+                tail += chunk;
+            }
+            tail_.store(tail);
+            if (producer_waiting_.load())
+            {
+                lock_guard lock(mutex_);
+                space_ready_.notify_one();
+            }
+        }
+    }
+
+}  // namespace runtime
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Буфер потока вывода, передающий данные в поток target в отдельном потоке записи.
+     *
+     * Записанные байты попадают в кольцевой буфер с одним писателем и одним читателем.
+     * Выполнение программы лишь копирует байты и публикует новую позицию атомарной переменной,
+     * поэтому медленный приёмник (например, канал) не задерживает каждую команду print.
+     * Поток записи забирает данные и сбрасывает target, когда кольцевой буфер опустел.
+     * Если буфер заполнен, пишущий поток ждёт, пока поток записи не освободит место.
+     *
+     * Записывать в буфер может только один поток. sync (и std::endl) передаёт данные потоку
+     * записи, не дожидаясь их записи. Flush дожидается, пока все записанные байты не окажутся
+     * в target и target не будет сброшен. Деструктор вызывает Flush
+     */
+    class AsyncOutputBuffer : public std::streambuf {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = size_t{1} << 16;
+
+        // Ёмкость кольцевого буфера округляется вверх до степени двойки
+        explicit AsyncOutputBuffer(std::ostream& target, size_t capacity = DEFAULT_CAPACITY);
+
+        AsyncOutputBuffer(const AsyncOutputBuffer&) = delete;
+        AsyncOutputBuffer& operator=(const AsyncOutputBuffer&) = delete;
+
+        ~AsyncOutputBuffer() override;
+
+        void Flush();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        // Передаёт накопленные в области записи байты в кольцевой буфер
+        void PublishPending();
+        void Push(const char* data, size_t size);
+        void RunWriter();
+
+        std::ostream& target_;
+        std::vector<char> ring_;
+        size_t mask_;
+        // Небольшая область записи streambuf, чтобы не обращаться к атомарным переменным на каждый байт
+        std::array<char, 1024> pending_{};
+
+        // Сколько байтов записано в кольцевой буфер и сколько из них забрал поток записи
+        alignas(64) std::atomic<size_t> head_ = 0;
+        alignas(64) std::atomic<size_t> tail_ = 0;
+        // Сколько байтов записано в target и сброшено
+        std::atomic<size_t> flushed_ = 0;
+
+        // Ожидание используется, только когда буфер пуст или заполнен
+        std::mutex mutex_;
+        std::condition_variable data_ready_;
+        std::condition_variable space_ready_;
+        std::atomic<bool> writer_waiting_ = false;
+        std::atomic<bool> producer_waiting_ = false;
+        bool stop_ = false;
+
+        std::thread writer_;
+    };
+
+    // Контекст, вывод которого записывается в поток target в отдельном потоке (см. AsyncOutputBuffer)
+    class AsyncOutputContext : public Context {
+    public:
+        explicit AsyncOutputContext(std::ostream& target, size_t capacity = AsyncOutputBuffer::DEFAULT_CAPACITY)
+            : buffer_(target, capacity) {
+        }
+
+        std::ostream& GetOutputStream() override {
+            return output_;
+        }
+
+        // Дожидается записи всего выведенного в target. Нужно вызывать перед тем, как выводить
+        // что-либо в target или в связанные с ним потоки (например, сообщение об ошибке)
+        void Flush() {
+            output_.flush();
+            buffer_.Flush();
+        }
+
+    private:
+        AsyncOutputBuffer buffer_;
+        std::ostream output_{&buffer_};
+    };
+
+}  // namespace runtime
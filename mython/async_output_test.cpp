@@ -0,0 +1,105 @@
+#include "async_output.h"
+#include "lexer.h"
+#include "parse.h"
+#include "test_runner.h"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Приёмник, медленно принимающий данные, чтобы кольцевой буфер заполнялся
+class SlowBuffer : public streambuf {
+public:
+    [[nodiscard]] const string& GetData() const {
+        return data_;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            data_.push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    streamsize xsputn(const char* s, streamsize count) override {
+        this_thread::sleep_for(chrono::microseconds(20));
+        data_.append(s, static_cast<size_t>(count));
+        return count;
+    }
+
+private:
+    string data_;
+};
+
+void TestOrderingWithBackPressure() {
+    SlowBuffer slow;
+    ostream target(&slow);
+    string expected;
+    {
+        // Ёмкость меньше одной строки, поэтому запись постоянно ждёт поток записи
+        runtime::AsyncOutputBuffer buffer(target, 16);
+        ostream output(&buffer);
+        for (int i = 0; i < 2000; ++i) {
+            const string line = "line number "s + to_string(i) + "\n"s;
+            output << line;
+            expected += line;
+            if (i % 100 == 0) {
+                output << flush;
+            }
+        }
+        // Вывод сохраняется и без явного Flush: его вызывает деструктор
+    }
+    ASSERT_EQUAL(slow.GetData(), expected);
+}
+
+void TestFlush() {
+    ostringstream target;
+    runtime::AsyncOutputBuffer buffer(target);
+    ostream output(&buffer);
+    output << "first"sv << 1 << endl;
+    buffer.Flush();
+    ASSERT_EQUAL(target.str(), "first1\n"s);
+    output << "second"sv;
+    output.flush();
+    buffer.Flush();
+    ASSERT_EQUAL(target.str(), "first1\nsecond"s);
+    // Повторный Flush без новых данных сразу завершается
+    buffer.Flush();
+    ASSERT_EQUAL(target.str(), "first1\nsecond"s);
+}
+
+void TestAsyncOutputContext() {
+    istringstream input(R"(
+for i in range(3):
+  print 'x', i
+print 1 / 0
+)");
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+
+    ostringstream target;
+    runtime::AsyncOutputContext context(target, 64);
+    runtime::Closure closure;
+    try {
+        program->Execute(closure, context);
+        ASSERT(false);
+    } catch (const runtime_error&) {
+        // Вывод, сделанный до ошибки, попадает в target раньше сообщения о ней
+        context.Flush();
+        target << "error\n"sv;
+    }
+    ASSERT_EQUAL(target.str(), "x 0\nx 1\nx 2\nerror\n"s);
+}
+
+}  // namespace
+
+void RunAsyncOutputTests(TestRunner& tr) {
+    RUN_TEST(tr, TestOrderingWithBackPressure);
+    RUN_TEST(tr, TestFlush);
+    RUN_TEST(tr, TestAsyncOutputContext);
+}
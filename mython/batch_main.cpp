@@ -0,0 +1,310 @@
+// Пакетный запуск множества программ Mython в одном процессе.
+//
+// Использование: mython_batch [--threads=N] [--recursion-limit=N] [--max-steps=N] [--max-heap-bytes=N]
+//                             [--timeout-ms=N] [--preempt=N] [--no-optimize] [manifest]
+//
+// Манифест читается из файла или, если он не указан, из стандартного ввода. Каждая строка
+// описывает одну задачу: путь к программе и начальные значения её глобальных переменных
+//
+//   scripts/fib.my n=20 name='fib'
+//   scripts/fib.my n=-1
+//
+// Значения записываются так же, как в программах: числа, строки, True, False и None.
+// Пустые строки и строки, начинающиеся с #, пропускаются. Относительные пути отсчитываются
+// от каталога манифеста. Каждая программа разбирается один раз, сколько бы задач её ни
+// использовало. Ограничения шагов, памяти и времени действуют на каждую задачу отдельно.
+// Результаты выводятся в порядке задач, сводка — в стандартный поток ошибок.
+//
+// С --preempt=N задачи выполняются вперемешку: каждая уступает поток другой после N шагов
+// (см. scheduler.h), поэтому долгие задачи не задерживают остальные. Глубина рекурсии в этом
+// режиме ограничена ещё и размером стека задачи
+
+#include "command_line.h"
+#include "lexer.h"
+#include "parse.h"
+#include "program_runner.h"
+#include "scheduler.h"
+#include "runtime.h"
+#include "source_map.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Script {
+    string path;
+    unique_ptr<runtime::Executable> program;
+    parse::SourceMap source_map;
+    // Ошибка чтения или разбора программы
+    string error;
+};
+
+struct BatchTask {
+    size_t script = 0;
+    runtime::Closure globals;
+};
+
+class ManifestError : public runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+runtime::ObjectHolder ParseValue(parse::Lexer& lexer) {
+    using namespace parse::token_type;
+
+    const auto& token = lexer.CurrentToken();
+    if (token == parse::Token{Char{'-'}}) {
+        return runtime::ObjectHolder::Own(runtime::Number{-lexer.ExpectNext<Number>().value});
+    }
+    if (const auto* number = token.TryAs<Number>()) {
+        return runtime::ObjectHolder::Own(runtime::Number{number->value});
+    }
+    if (const auto* str = token.TryAs<String>()) {
+        return runtime::ObjectHolder::Own(runtime::String{str->value});
+    }
+    if (token.Is<True>()) {
+        return runtime::ObjectHolder::Own(runtime::Bool{true});
+    }
+    if (token.Is<False>()) {
+        return runtime::ObjectHolder::Own(runtime::Bool{false});
+    }
+    if (token.Is<None>()) {
+        return runtime::ObjectHolder::None();
+    }
+    throw ManifestError("Expected a number, string, True, False or None"s);
+}
+
+// Разбирает начальные значения глобальных переменных вида name=value
+runtime::Closure ParseGlobals(istream& input) {
+    using namespace parse::token_type;
+
+    runtime::Closure globals;
+    parse::Lexer lexer(input);
+    while (!lexer.CurrentToken().Is<Newline>() && !lexer.CurrentToken().Is<Eof>()) {
+        const string name = lexer.Expect<Id>().value;
+        lexer.ExpectNext<Char>('=');
+        lexer.NextToken();
+        globals[name] = ParseValue(lexer);
+        lexer.NextToken();
+    }
+    return globals;
+}
+
+class Batch {
+public:
+    explicit Batch(filesystem::path base_dir)
+        : base_dir_(std::move(base_dir)) {
+    }
+
+    void ReadManifest(istream& input) {
+        string line;
+        for (size_t line_number = 1; getline(input, line); ++line_number) {
+            istringstream line_input(line);
+            string path;
+            if (!(line_input >> path) || path[0] == '#') {
+                continue;
+            }
+            try {
+                // Отступ в начале строки лексер воспринял бы как Indent
+                line_input >> ws;
+                tasks_.push_back({GetScript(path), ParseGlobals(line_input)});
+            } catch (const exception& e) {
+                throw ManifestError("Manifest line "s + to_string(line_number) + ": "s + e.what());
+            }
+        }
+    }
+
+    // Разбирает все программы, затем выполняет задачи и выводит результаты в порядке задач
+    // Если preempt_slice не 0, задачи чередуются через каждые preempt_slice шагов
+    bool Run(ThreadPool& pool, const ParseOptions& options, size_t max_call_depth,
+             const runtime::ExecutionLimits& limits, uint64_t preempt_slice, ostream& out, ostream& summary) {
+        const auto start = chrono::steady_clock::now();
+
+        for (auto& script : scripts_) {
+            pool.Submit([this, &script, &options] {
+                LoadScript(script, options);
+            });
+        }
+        pool.Wait();
+
+        vector<ProgramTask> runnable;
+        vector<size_t> runnable_index(tasks_.size(), tasks_.size());
+        for (size_t i = 0; i < tasks_.size(); ++i) {
+            const Script& script = scripts_[tasks_[i].script];
+            if (script.program) {
+                runnable_index[i] = runnable.size();
+                runnable.push_back({script.program.get(), std::move(tasks_[i].globals), &script.source_map});
+            }
+        }
+        vector<ProgramResult> results;
+        if (preempt_slice > 0) {
+            SchedulerOptions scheduler_options;
+            scheduler_options.threads = pool.GetThreadCount();
+            scheduler_options.slice_steps = preempt_slice;
+            scheduler_options.max_call_depth = max_call_depth;
+            scheduler_options.limits = limits;
+            results = RunProgramsPreemptive(runnable, scheduler_options);
+        } else {
+            results = RunPrograms(pool, runnable, max_call_depth, limits);
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        size_t failed = 0;
+        for (size_t i = 0; i < tasks_.size(); ++i) {
+            const Script& script = scripts_[tasks_[i].script];
+            if (runnable_index[i] == tasks_.size()) {
+                ++failed;
+                out << "=== "sv << i + 1 << ' ' << script.path << ": error"sv << endl;
+                out << "Error: "sv << script.error << endl;
+                continue;
+            }
+
+            const ProgramResult& result = results[runnable_index[i]];
+            const double ms = chrono::duration<double, milli>(result.duration).count();
+            failed += result.error.empty() ? 0 : 1;
+            out << "=== "sv << i + 1 << ' ' << script.path << (result.error.empty() ? ": ok, "sv : ": error, "sv)
+                << fixed << setprecision(3) << ms << " ms"sv << endl;
+            out << result.output;
+            if (!result.error.empty()) {
+                out << "Error: "sv << result.error << endl;
+            }
+        }
+
+        summary << tasks_.size() << " tasks ("sv << failed << " failed), "sv << scripts_.size() << " scripts, "sv
+                << pool.GetThreadCount() << " threads: "sv << fixed << setprecision(3) << seconds << " s, "sv
+                << setprecision(1) << (seconds > 0 ? tasks_.size() / seconds : 0.0) << " tasks/s, "sv
+                << pool.GetStolenCount() << " stolen"sv << endl;
+        return failed == 0;
+    }
+
+private:
+    size_t GetScript(const string& path) {
+        const auto [it, inserted] = script_index_.emplace(path, scripts_.size());
+        if (inserted) {
+            scripts_.push_back({path, nullptr, {}, {}});
+        }
+        return it->second;
+    }
+
+    void LoadScript(Script& script, const ParseOptions& options) const {
+        const filesystem::path path = base_dir_ / script.path;
+        try {
+            ifstream input(path);
+            if (!input) {
+                throw runtime_error("Cannot open "s + path.string());
+            }
+            parse::Lexer lexer(input);
+            ParseOptions script_options = options;
+            script_options.source_map = &script.source_map;
+            script.program = ParseProgram(lexer, script_options);
+        } catch (const exception& e) {
+            script.error = e.what();
+        }
+    }
+
+    filesystem::path base_dir_;
+    vector<Script> scripts_;
+    unordered_map<string, size_t> script_index_;
+    vector<BatchTask> tasks_;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const auto threads_option = "--threads="sv;
+    const auto recursion_limit_option = "--recursion-limit="sv;
+    const auto max_steps_option = "--max-steps="sv;
+    const auto max_heap_option = "--max-heap-bytes="sv;
+    const auto timeout_option = "--timeout-ms="sv;
+    const auto preempt_option = "--preempt="sv;
+
+    ParseOptions options;
+    size_t max_call_depth = runtime::Context::DEFAULT_MAX_CALL_DEPTH;
+    runtime::ExecutionLimits limits;
+    uint64_t preempt_slice = 0;
+    size_t threads = thread::hardware_concurrency();
+    string manifest_path;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg.substr(0, threads_option.size()) == threads_option) {
+            const auto count = ParseOptionValue<size_t>(arg.substr(threads_option.size()));
+            if (!count) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            threads = *count;
+        } else if (arg.substr(0, recursion_limit_option.size()) == recursion_limit_option) {
+            const auto depth = ParseOptionValue<size_t>(arg.substr(recursion_limit_option.size()));
+            if (!depth) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            max_call_depth = *depth;
+        } else if (arg.substr(0, max_steps_option.size()) == max_steps_option) {
+            const auto steps = ParseOptionValue<uint64_t>(arg.substr(max_steps_option.size()));
+            if (!steps) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            limits.max_steps = *steps;
+        } else if (arg.substr(0, max_heap_option.size()) == max_heap_option) {
+            const auto bytes = ParseOptionValue<size_t>(arg.substr(max_heap_option.size()));
+            if (!bytes) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            limits.max_heap_bytes = *bytes;
+        } else if (arg.substr(0, timeout_option.size()) == timeout_option) {
+            const auto timeout = ParseOptionMilliseconds(arg.substr(timeout_option.size()));
+            if (!timeout) {
+                return ReportInvalidOption(arg, "a non-negative number of milliseconds"sv);
+            }
+            limits.timeout = *timeout;
+        } else if (arg.substr(0, preempt_option.size()) == preempt_option) {
+            const auto slice = ParseOptionValue<uint64_t>(arg.substr(preempt_option.size()));
+            if (!slice) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            preempt_slice = *slice;
+        } else if (arg == "--no-optimize"sv) {
+            options.optimize = false;
+        } else if (manifest_path.empty() && arg.substr(0, 2) != "--"sv) {
+            manifest_path = arg;
+        } else {
+            cerr << "Unknown option: "sv << arg << endl;
+            return 1;
+        }
+    }
+
+    try {
+        bool ok = false;
+        ThreadPool pool(threads);
+        if (manifest_path.empty()) {
+            Batch batch(filesystem::current_path());
+            batch.ReadManifest(cin);
+            ok = batch.Run(pool, options, max_call_depth, limits, preempt_slice, cout, cerr);
+        } else {
+            ifstream manifest(manifest_path);
+            if (!manifest) {
+                cerr << "Cannot open "sv << manifest_path << endl;
+                return 1;
+            }
+            Batch batch(filesystem::path(manifest_path).parent_path());
+            batch.ReadManifest(manifest);
+            ok = batch.Run(pool, options, max_call_depth, limits, preempt_slice, cout, cerr);
+        }
+        return ok ? 0 : 2;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
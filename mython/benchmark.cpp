@@ -0,0 +1,159 @@
+#include "lexer.h"
+#include "parse.h"
+#include "program_runner.h"
+#include "runtime.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Число вычислений условия за один запуск сценария (глубина рекурсии метода run)
+const int GUARDS_PER_RUN = 500;
+const int RUNS = 200;
+
+// Сценарий с большим числом условий-охранников: дорогой метод вызывается, только если
+// дешёвая проверка flag прошла. Подставляемое условие задаётся через {GUARD}
+const string GUARD_PROGRAM = R"(
+class Checker:
+  def __init__():
+    self.hits = 0
+
+  def expensive(n):
+    s = str(n) + ':' + str(n * 2) + ':' + str(n * 3)
+    return s != ''
+
+  def run(n, flag):
+    if n > 0:
+{GUARD}
+      self.run(n - 1, flag)
+
+c = Checker()
+c.run({N}, {FLAG})
+print c.hits
+)";
+
+string MakeProgram(const string& guard, const string& flag) {
+    string program = GUARD_PROGRAM;
+    auto replace = [&program](const string& from, const string& to) {
+        program.replace(program.find(from), from.size(), to);
+    };
+    replace("{GUARD}"s, guard);
+    replace("{N}"s, to_string(GUARDS_PER_RUN));
+    replace("{FLAG}"s, flag);
+    return program;
+}
+
+// Разбирает программу один раз, выполняет её RUNS раз и выводит среднее время вычисления
+// одного условия. Разбор программы в замер не входит
+void RunCase(const string& name, const string& program, ostream& out) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    chrono::steady_clock::duration total{};
+    for (int i = 0; i < RUNS; ++i) {
+        ostringstream output;
+        runtime::SimpleContext context{output};
+        runtime::Closure closure;
+
+        auto start = chrono::steady_clock::now();
+        tree->Execute(closure, context);
+        total += chrono::steady_clock::now() - start;
+    }
+
+    const double guards = static_cast<double>(GUARDS_PER_RUN) * RUNS;
+    const double ns = static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(total).count());
+    out << left << setw(28) << name << right << setw(10) << fixed << setprecision(1) << ns / guards
+        << " ns/guard"sv << setw(12) << setprecision(0) << guards / (ns / 1e9) << " guards/s"sv << endl;
+}
+
+// Вычислительно тяжёлая программа для замера масштабирования: вход задаётся глобальной
+// переменной seed, которая у каждого задания своя
+const string SCALING_PROGRAM = R"(
+def collatz(n):
+  steps = 0
+  while n != 1:
+    if n - n / 2 * 2 == 0:
+      n = n / 2
+    else:
+      n = 3 * n + 1
+    steps = steps + 1
+  return steps
+
+total = 0
+for i in range(seed, seed + 300):
+  total = total + collatz(i)
+print total
+)";
+
+const int SCALING_TASKS = 64;
+
+}  // namespace
+
+// Выполняет одну разобранную программу SCALING_TASKS раз на пулах из 1, 2, 4, ...
+// потоков и выводит ускорение относительно одного потока
+void RunScalingBenchmark(ostream& out) {
+    istringstream input(SCALING_PROGRAM);
+    parse::Lexer lexer(input);
+    auto tree = ParseProgram(lexer);
+
+    vector<ProgramTask> tasks(SCALING_TASKS);
+    for (int i = 0; i < SCALING_TASKS; ++i) {
+        tasks[i].program = tree.get();
+        tasks[i].globals["seed"s] = runtime::ObjectHolder::Own(runtime::Number{1 + i * 300});
+    }
+
+    const size_t max_threads = max(1u, thread::hardware_concurrency());
+    out << "Scaling benchmark: "sv << SCALING_TASKS << " tasks, up to "sv << max_threads << " threads"sv << endl;
+
+    double single_thread_seconds = 0;
+    for (size_t threads = 1;; threads = min(threads * 2, max_threads)) {
+        ThreadPool pool(threads);
+        const auto start = chrono::steady_clock::now();
+        const auto results = RunPrograms(pool, tasks);
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        for (const auto& result : results) {
+            if (!result.error.empty()) {
+                out << "Error: "sv << result.error << endl;
+                return;
+            }
+        }
+        if (threads == 1) {
+            single_thread_seconds = seconds;
+        }
+        out << setw(4) << threads << " threads"sv << setw(10) << fixed << setprecision(3) << seconds << " s"sv
+            << setw(10) << setprecision(1) << SCALING_TASKS / seconds << " tasks/s"sv << setw(8)
+            << setprecision(2) << single_thread_seconds / seconds << "x"sv << endl;
+
+        if (threads == max_threads) {
+            break;
+        }
+    }
+}
+
+// Сравнивает стоимость охраняющих условий: and с дорогим rhs против вложенных if.
+// Так как and вычисляет rhs лишь при истинном lhs, при ложном flag оба варианта
+// должны стоить одинаково дёшево
+void RunGuardBenchmarks(ostream& out) {
+    const string and_guard = "      if flag and self.expensive(n):\n        self.hits = self.hits + 1"s;
+    const string nested_guard
+        = "      if flag:\n        if self.expensive(n):\n          self.hits = self.hits + 1"s;
+    const string truthiness_guard = "      if n and flag and 'x' and not None:\n        self.hits = self.hits + 1"s;
+
+    out << "Guard benchmark: "sv << GUARDS_PER_RUN << " guards x "sv << RUNS << " runs"sv << endl;
+    RunCase("and, lhs false"s, MakeProgram(and_guard, "False"s), out);
+    RunCase("nested if, lhs false"s, MakeProgram(nested_guard, "False"s), out);
+    RunCase("and, lhs true"s, MakeProgram(and_guard, "True"s), out);
+    RunCase("nested if, lhs true"s, MakeProgram(nested_guard, "True"s), out);
+    RunCase("truthiness chain"s, MakeProgram(truthiness_guard, "1"s), out);
+}
@@ -0,0 +1,41 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+void RunGuardBenchmarks(ostream& out);
+void RunScalingBenchmark(ostream& out);
+void RunWorkloadBenchmarks(ostream& out, int runs, bool json);
+
+// Использование: mython_benchmark [--runs=N] [--json]
+// С --json выводятся только результаты сценариев нагрузки в формате JSON
+int main(int argc, char* argv[]) {
+    const auto runs_option = "--runs="sv;
+
+    int runs = 5;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg.substr(0, runs_option.size()) == runs_option) {
+            runs = max(1, stoi(string(arg.substr(runs_option.size()))));
+        } else if (arg == "--json"sv) {
+            json = true;
+        } else {
+            std::cerr << "Unknown option: "sv << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        RunWorkloadBenchmarks(cout, runs, json);
+        if (!json) {
+            RunGuardBenchmarks(cout);
+            RunScalingBenchmark(cout);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
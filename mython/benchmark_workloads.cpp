@@ -0,0 +1,307 @@
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+atomic<size_t> allocation_count = 0;
+atomic<size_t> allocated_bytes = 0;
+
+}  // namespace
+
+// Замена глобальных operator new/delete для подсчёта выделений памяти. Действует во всём
+// исполняемом файле, поэтому этот файл подключается только к цели mython_benchmark
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    allocated_bytes.fetch_add(size, memory_order_relaxed);
+    if (void* ptr = malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+
+// Сценарий нагрузки. ops — число характерных операций за один запуск программы
+// (вызовов, узлов, строк и т.п.), по нему считается ops/s
+struct Workload {
+    string name;
+    string program;
+    long long ops;
+};
+
+const int FIB_N = 18;
+const int LIST_NODES = 2000;
+const int STRING_PARTS = 2000;
+const int SORT_ITEMS = 120;
+const int PRINT_LINES = 5000;
+const int PRINT_VALUE_LINES = 5000;
+const int PRINT_VALUES_PER_LINE = 8;
+
+long long FibCalls(int n) {
+    long long a = 1;
+    long long b = 1;
+    for (int i = 1; i < n; ++i) {
+        const long long next = a + b + 1;
+        a = b;
+        b = next;
+    }
+    return n < 1 ? 1 : b;
+}
+
+vector<Workload> MakeWorkloads() {
+    return {
+        {"fib_methods"s, R"(
+class Fib:
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+f = Fib()
+print f.fib()"s + to_string(FIB_N) + ")\n"s,
+         FibCalls(FIB_N)},
+        {"linked_list"s, R"(
+class Node:
+  def __init__(value, next):
+    self.value = value
+    self.next = next
+
+head = None
+for i in range(0, )"s + to_string(LIST_NODES) + R"():
+  head = Node(i, head)
+
+total = 0
+node = head
+for i in range(0, )"s + to_string(LIST_NODES) + R"():
+  total = total + node.value
+  node = node.next
+print total
+)"s,
+         LIST_NODES},
+        {"string_building"s, R"(
+s = ''
+for i in range(0, )"s + to_string(STRING_PARTS) + R"():
+  s = s + str(i) + ','
+print len(s)
+)"s,
+         STRING_PARTS},
+        {"sort_lt"s, R"(
+class Item:
+  def __init__(key):
+    self.key = key
+
+  def __lt__(other):
+    return self.key < other.key
+
+items = []
+for i in range(0, )"s + to_string(SORT_ITEMS) + R"():
+  items.append(Item()"s + to_string(SORT_ITEMS) + R"( - i))
+
+for i in range(1, len(items)):
+  j = i
+  while j > 0 and items[j] < items[j - 1]:
+    t = items[j]
+    items[j] = items[j - 1]
+    items[j - 1] = t
+    j = j - 1
+first = items[0]
+last = items[len(items) - 1]
+print first.key, last.key
+)"s,
+         // Вход упорядочен по убыванию, поэтому сравнивается каждая пара элементов
+         static_cast<long long>(SORT_ITEMS) * (SORT_ITEMS - 1) / 2},
+        {"print_heavy"s, R"(
+for i in range(0, )"s + to_string(PRINT_LINES) + R"():
+  print i, 'line', i * 2, True
+)"s,
+         PRINT_LINES},
+        // Пропускная способность print: операцией считается выведенное значение
+        {"print_values"s, R"(
+for i in range(0, )"s + to_string(PRINT_VALUE_LINES) + R"():
+  print i, -i, i * 1000, i * 7919, 0 - i * 104729, str(i), True, False
+)"s,
+         static_cast<long long>(PRINT_VALUE_LINES) * PRINT_VALUES_PER_LINE},
+    };
+}
+
+struct PhaseStats {
+    double seconds = 0;
+    size_t allocations = 0;
+    size_t bytes = 0;
+    // Пиковый размер резидентной памяти за фазу, КБ (0, если неизвестен)
+    long peak_rss_kb = 0;
+};
+
+// Сбрасывает счётчик пикового RSS процесса (Linux 4.0+). Если сбросить не удалось,
+// пик фазы будет не меньше пика всего процесса до неё
+void ResetPeakRss() {
+    ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+long ReadPeakRssKb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return stol(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+// Выполняет run runs раз и возвращает средние по запускам время и выделения памяти
+template <typename Run>
+PhaseStats MeasurePhase(int runs, Run run) {
+    ResetPeakRss();
+    const size_t allocations_before = allocation_count.load(memory_order_relaxed);
+    const size_t bytes_before = allocated_bytes.load(memory_order_relaxed);
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i) {
+        run();
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    PhaseStats stats;
+    stats.seconds = chrono::duration<double>(duration).count() / runs;
+    stats.allocations = (allocation_count.load(memory_order_relaxed) - allocations_before) / runs;
+    stats.bytes = (allocated_bytes.load(memory_order_relaxed) - bytes_before) / runs;
+    stats.peak_rss_kb = ReadPeakRssKb();
+    return stats;
+}
+
+struct WorkloadResult {
+    const Workload* workload = nullptr;
+    size_t tokens = 0;
+    PhaseStats lex;
+    // Разбор включает лексический анализ, так как парсер читает лексемы из Lexer
+    PhaseStats parse;
+    PhaseStats execute;
+};
+
+WorkloadResult RunWorkload(const Workload& workload, int runs) {
+    WorkloadResult result;
+    result.workload = &workload;
+
+    result.lex = MeasurePhase(runs, [&] {
+        istringstream input(workload.program);
+        parse::Lexer lexer(input);
+        size_t tokens = 1;
+        while (!lexer.NextToken().Is<parse::token_type::Eof>()) {
+            ++tokens;
+        }
+        result.tokens = tokens;
+    });
+
+    unique_ptr<runtime::Executable> tree;
+    result.parse = MeasurePhase(runs, [&] {
+        istringstream input(workload.program);
+        parse::Lexer lexer(input);
+        tree = ParseProgram(lexer);
+    });
+
+    result.execute = MeasurePhase(runs, [&] {
+        ostringstream output;
+        runtime::SimpleContext context{output};
+        runtime::Closure closure;
+        tree->Execute(closure, context);
+    });
+    return result;
+}
+
+void PrintText(ostream& out, const vector<WorkloadResult>& results, int runs) {
+    out << "Workload benchmark: "sv << runs << " runs per phase, values are per run"sv << endl;
+    out << left << setw(18) << "workload"sv << setw(9) << "phase"sv << right << setw(12) << "time, ms"sv << setw(14)
+        << "ops/s"sv << setw(12) << "allocs"sv << setw(14) << "bytes"sv << setw(14) << "peak RSS, KB"sv << endl;
+
+    for (const auto& result : results) {
+        auto print_phase = [&](string_view phase, const PhaseStats& stats, double ops) {
+            out << left << setw(18) << result.workload->name << setw(9) << phase << right << fixed << setw(12)
+                << setprecision(3) << stats.seconds * 1000 << setw(14) << setprecision(0) << ops / stats.seconds
+                << setw(12) << stats.allocations << setw(14) << stats.bytes << setw(14) << stats.peak_rss_kb
+                << endl;
+        };
+        // Для лексического анализа и разбора операцией считается лексема
+        print_phase("lex"sv, result.lex, static_cast<double>(result.tokens));
+        print_phase("parse"sv, result.parse, static_cast<double>(result.tokens));
+        print_phase("execute"sv, result.execute, static_cast<double>(result.workload->ops));
+    }
+}
+
+void PrintJsonPhase(ostream& out, const PhaseStats& stats, double ops) {
+    out << "{\"seconds\": "sv << stats.seconds << ", \"ops_per_second\": "sv << ops / stats.seconds
+        << ", \"allocations\": "sv << stats.allocations << ", \"bytes\": "sv << stats.bytes
+        << ", \"peak_rss_kb\": "sv << stats.peak_rss_kb << "}"sv;
+}
+
+void PrintJson(ostream& out, const vector<WorkloadResult>& results, int runs) {
+    out << setprecision(9) << "{\n  \"runs\": "sv << runs << ",\n  \"workloads\": ["sv;
+    bool first = true;
+    for (const auto& result : results) {
+        out << (first ? "\n"sv : ",\n"sv);
+        first = false;
+        out << "    {\"name\": \""sv << result.workload->name << "\", \"ops\": "sv << result.workload->ops
+            << ", \"tokens\": "sv << result.tokens << ",\n     \"lex\": "sv;
+        PrintJsonPhase(out, result.lex, static_cast<double>(result.tokens));
+        out << ",\n     \"parse\": "sv;
+        PrintJsonPhase(out, result.parse, static_cast<double>(result.tokens));
+        out << ",\n     \"execute\": "sv;
+        PrintJsonPhase(out, result.execute, static_cast<double>(result.workload->ops));
+        out << "}"sv;
+    }
+    out << "\n  ]\n}"sv << endl;
+}
+
+}  // namespace
+
+// Выполняет типичные сценарии нагрузки и выводит для фаз лексического анализа, разбора
+// и выполнения время, число операций в секунду, число и объём выделений памяти и пиковый RSS.
+// В формате JSON результаты разных версий удобно сравнивать между собой
+void RunWorkloadBenchmarks(ostream& out, int runs, bool json) {
+    const auto workloads = MakeWorkloads();
+    vector<WorkloadResult> results;
+    results.reserve(workloads.size());
+    for (const auto& workload : workloads) {
+        results.push_back(RunWorkload(workload, runs));
+    }
+
+    if (json) {
+        PrintJson(out, results, runs);
+    } else {
+        PrintText(out, results, runs);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Разбирает числовое значение параметра командной строки (N в --max-steps=N). Возвращает nullopt,
+// если text не целое число без знака (в том числе отрицательное) или оно не помещается в T
+template <typename T>
+std::optional<T> ParseOptionValue(std::string_view text) {
+    static_assert(std::is_unsigned_v<T>, "Option values are non-negative");
+    T value{};
+    const char* end = text.data() + text.size();
+    const auto [ptr, error] = std::from_chars(text.data(), end, value);
+    if (text.empty() || error != std::errc{} || ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Разбирает время в миллисекундах. Возвращает nullopt, если значение недопустимо
+// или не представимо в steady_clock::duration
+inline std::optional<std::chrono::steady_clock::duration> ParseOptionMilliseconds(std::string_view text) {
+    using std::chrono::milliseconds;
+    const auto value = ParseOptionValue<uint64_t>(text);
+    const auto max_value = std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::duration::max());
+    if (!value || *value > static_cast<uint64_t>(max_value.count())) {
+        return std::nullopt;
+    }
+    return milliseconds(*value);
+}
+
+// Сообщает о недопустимом значении параметра arg и возвращает код завершения программы
+inline int ReportInvalidOption(std::string_view arg, std::string_view expected) {
+    std::cerr << "Invalid option " << arg << ": expected " << expected << std::endl;
+    return 1;
+}
@@ -0,0 +1,105 @@
+#include "interpreter.h"
+
+#include "lexer.h"
+#include "source_map.h"
+#include "statistics.h"
+
+using namespace std;
+
+namespace {
+
+// Выполняет f с ограничениями памяти контекста и дополняет сообщение об ошибке выполнения
+// позицией инструкции, в которой она возникла
+template <typename F>
+auto WithErrorPosition(const runtime::Context& context, const parse::SourceMap& source_map, F f) {
+    try {
+        runtime::LimitScope limit_scope(context);
+        return f();
+    } catch (const std::runtime_error& e) {
+        const parse::SourceSpan* span = parse::FindCurrentErrorSpan(context, source_map);
+        if (span == nullptr) {
+            throw;
+        }
+        const string message = parse::DescribePosition(span->begin) + ": "s + e.what();
+        if (dynamic_cast<const runtime::RecursionError*>(&e) != nullptr) {
+            throw runtime::RecursionError(message);
+        }
+        if (dynamic_cast<const runtime::LimitError*>(&e) != nullptr) {
+            throw runtime::LimitError(message);
+        }
+        throw runtime_error(message);
+    }
+}
+
+}  // namespace
+
+Interpreter::Interpreter(ostream& output, ParseOptions options)
+    : options_(options)
+    , builtins_(options.builtins)
+    , context_(output) {
+    options_.builtins = &builtins_;
+    if (options_.source_map == nullptr) {
+        options_.source_map = &source_map_;
+    }
+}
+
+runtime::Builtins& Interpreter::GetBuiltins() {
+    return builtins_;
+}
+
+runtime::Context& Interpreter::GetContext() {
+    return context_;
+}
+
+void Interpreter::Load(istream& input) {
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer, options_);
+    programs_.push_back(std::move(program));
+    WithErrorPosition(context_, *options_.source_map, [this] {
+        return programs_.back()->Execute(globals_, context_);
+    });
+    if (runtime::Statistics* statistics = context_.GetStatistics()) {
+        statistics->NoteClosureSize(globals_.size());
+    }
+}
+
+runtime::ObjectHolder Interpreter::CallFunction(const string& name,
+                                                const vector<runtime::ObjectHolder>& args) {
+    const runtime::Function* function = GetGlobal(name).TryAs<runtime::Function>();
+    if (function == nullptr) {
+        function = builtins_.FindFunction(name);
+    }
+    if (function == nullptr) {
+        throw runtime_error("Function "s + name + " is not defined"s);
+    }
+    return WithErrorPosition(context_, *options_.source_map, [&] {
+        return runtime::CallFunction(*function, args, context_);
+    });
+}
+
+runtime::ObjectHolder Interpreter::CallMethod(const runtime::ObjectHolder& object, const string& method,
+                                              const vector<runtime::ObjectHolder>& args) {
+    auto instance = object.TryAs<runtime::ClassInstance>();
+    if (instance == nullptr) {
+        throw runtime_error("Cannot call method "s + method + " of a non-object"s);
+    }
+    return WithErrorPosition(context_, *options_.source_map, [&] {
+        return instance->Call(method, args, context_);
+    });
+}
+
+runtime::ObjectHolder Interpreter::CallMethod(const string& object_name, const string& method,
+                                              const vector<runtime::ObjectHolder>& args) {
+    return CallMethod(GetGlobal(object_name), method, args);
+}
+
+runtime::ObjectHolder Interpreter::GetGlobal(const string& name) const {
+    if (auto it = globals_.find(name); it != globals_.end()) {
+        return it->second;
+    }
+    return runtime::ObjectHolder::None();
+}
+
+void Interpreter::SetGlobal(const string& name, runtime::ObjectHolder value) {
+    globals_[name] = std::move(value);
+}
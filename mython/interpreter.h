@@ -0,0 +1,75 @@
+#pragma once
+
+#include "parse.h"
+#include "runtime.h"
+#include "source_map.h"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Интерпретатор Mython для встраивания в приложения на C++.
+ *
+ * Приложение регистрирует свои функции и классы в GetBuiltins(), затем загружает одну
+ * или несколько программ методом Load. Все программы выполняются с общим набором глобальных
+ * переменных, к которым приложение обращается через GetGlobal и SetGlobal, и могут вызываться
+ * приложением через CallFunction и CallMethod. Значения Number, String и Bool передаются
+ * между C++ и Mython как есть, в виде runtime::ObjectHolder, без преобразований.
+ *
+ * Функции разрешаются на этапе разбора, поэтому программа видит только свои функции
+ * и функции из GetBuiltins(), зарегистрированные до её загрузки
+ */
+class Interpreter {
+public:
+    // Если в options.builtins передан реестр приложения, GetBuiltins() дополняет его: программы
+    // видят функции и классы обоих реестров, а регистрация в GetBuiltins() имени из реестра
+    // приложения выбрасывает runtime_error. Реестр приложения должен существовать, пока
+    // существует интерпретатор
+    explicit Interpreter(std::ostream& output, ParseOptions options = {});
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // Возвращает реестр функций и классов, реализованных на C++ (см. конструктор)
+    [[nodiscard]] runtime::Builtins& GetBuiltins();
+
+    // Возвращает контекст, в котором выполняются программы (вывод, ограничения выполнения).
+    // При превышении ограничений Load, CallFunction и CallMethod выбрасывают LimitError,
+    // а интерпретатор остаётся пригодным к работе после нового вызова Context::SetLimits
+    [[nodiscard]] runtime::Context& GetContext();
+
+    // Разбирает программу из input и выполняет её. Ошибки разбора выбрасываются как ParseError,
+    // ошибки выполнения - как runtime_error. Сообщения об ошибках выполнения здесь, а также
+    // в CallFunction и CallMethod начинаются с позиции инструкции, в которой возникла ошибка
+    void Load(std::istream& input);
+
+    // Вызывает функцию name программы или функцию из GetBuiltins().
+    // Если функция не найдена, выбрасывает runtime_error
+    runtime::ObjectHolder CallFunction(const std::string& name,
+                                       const std::vector<runtime::ObjectHolder>& args = {});
+
+    // Вызывает метод method у объекта object. Если object - не экземпляр класса
+    // либо у него нет такого метода, выбрасывает runtime_error
+    runtime::ObjectHolder CallMethod(const runtime::ObjectHolder& object, const std::string& method,
+                                     const std::vector<runtime::ObjectHolder>& args = {});
+    // Вызывает метод method у объекта из глобальной переменной object_name
+    runtime::ObjectHolder CallMethod(const std::string& object_name, const std::string& method,
+                                     const std::vector<runtime::ObjectHolder>& args = {});
+
+    // Возвращает значение глобальной переменной name или None, если переменной нет
+    [[nodiscard]] runtime::ObjectHolder GetGlobal(const std::string& name) const;
+    void SetGlobal(const std::string& name, runtime::ObjectHolder value);
+
+private:
+    ParseOptions options_;
+    // Участки исходного текста узлов загруженных программ, если в options не передана своя карта
+    parse::SourceMap source_map_;
+    runtime::Builtins builtins_;
+    runtime::SimpleContext context_;
+    // Разобранные программы владеют своими классами и функциями,
+    // поэтому хранятся, пока существует интерпретатор
+    std::vector<std::unique_ptr<runtime::Executable>> programs_;
+    runtime::Closure globals_;
+};
@@ -0,0 +1,317 @@
+#include "interpreter.h"
+#include "test_runner.h"
+
+#include <sstream>
+
+using namespace std;
+using runtime::ObjectHolder;
+
+namespace {
+
+void TestLoadAndCall() {
+    ostringstream output;
+    Interpreter interpreter(output);
+
+    istringstream program(R"(
+class Greeter:
+  def __init__(greeting):
+    self.greeting = greeting
+
+  def greet(name):
+    return self.greeting + ', ' + name
+
+def square(x):
+  return x * x
+
+greeter = Greeter('Hello')
+limit = 10
+print 'loaded'
+)");
+    interpreter.Load(program);
+    ASSERT_EQUAL(output.str(), "loaded\n"s);
+
+    ASSERT_EQUAL(interpreter.CallFunction("square"s, {ObjectHolder::Own(runtime::Number{7})})
+                     .TryAs<runtime::Number>()
+                     ->GetValue(),
+                 49);
+    ASSERT_EQUAL(interpreter.CallMethod("greeter"s, "greet"s, {ObjectHolder::Own(runtime::String{"C++"s})})
+                     .TryAs<runtime::String>()
+                     ->GetValue(),
+                 "Hello, C++"s);
+    ASSERT_EQUAL(interpreter.GetGlobal("limit"s).TryAs<runtime::Number>()->GetValue(), 10);
+    ASSERT(!interpreter.GetGlobal("missing"s));
+
+    // Следующая программа видит глобальные переменные, заданные приложением и предыдущей программой
+    interpreter.SetGlobal("limit"s, ObjectHolder::Own(runtime::Number{20}));
+    istringstream next_program("print limit, greeter.greet('again')\n");
+    interpreter.Load(next_program);
+    ASSERT_EQUAL(output.str(), "loaded\n20 Hello, again\n"s);
+
+    ASSERT_THROWS(interpreter.CallFunction("missing"s), runtime_error);
+    ASSERT_THROWS(interpreter.CallMethod("limit"s, "greet"s), runtime_error);
+    ASSERT_THROWS(interpreter.CallMethod("greeter"s, "missing"s), runtime_error);
+}
+
+void TestNativeFunctions() {
+    ostringstream output;
+    Interpreter interpreter(output);
+
+    const runtime::Object* passed = nullptr;
+    interpreter.GetBuiltins().AddFunction(
+        "clamp"s, {"value"s, "low"s, "high"s},
+        [&passed](const vector<ObjectHolder>& args, runtime::Context&) {
+            passed = args[0].Get();
+            const int value = args[0].TryAs<runtime::Number>()->GetValue();
+            const int low = args[1].TryAs<runtime::Number>()->GetValue();
+            const int high = args[2].TryAs<runtime::Number>()->GetValue();
+            return ObjectHolder::FromNumber(std::min(std::max(value, low), high));
+        });
+    interpreter.GetBuiltins().AddFunction("log"s, {"message"s},
+                                          [](const vector<ObjectHolder>& args, runtime::Context& context) {
+                                              context.GetOutputStream() << "log: "sv;
+                                              args[0]->Print(context.GetOutputStream(), context);
+                                              context.GetOutputStream() << '\n';
+                                              return ObjectHolder::None();
+                                          });
+    ASSERT_THROWS(interpreter.GetBuiltins().AddFunction("log"s, {}, {}), runtime_error);
+
+    // Значение передаётся в функцию на C++ тем же объектом, без копирования
+    auto big = ObjectHolder::Own(runtime::Number{5000});
+    interpreter.SetGlobal("big"s, big);
+
+    istringstream program(R"(
+def limited(x):
+  return clamp(x, 0, 100)
+
+print limited(-5), limited(50), clamp(big, 0, 10)
+log('done')
+)");
+    interpreter.Load(program);
+    ASSERT_EQUAL(output.str(), "0 50 10\nlog: done\n"s);
+    ASSERT(passed == big.Get());
+    ASSERT_EQUAL(interpreter.CallFunction("clamp"s, {big, ObjectHolder::FromNumber(0), ObjectHolder::FromNumber(1)})
+                     .TryAs<runtime::Number>()
+                     ->GetValue(),
+                 1);
+
+    istringstream redefinition("def clamp(x, y, z):\n  return x\n");
+    ASSERT_THROWS(interpreter.Load(redefinition), ParseError);
+}
+
+void TestHostBuiltins() {
+    // Реестр приложения передаётся через ParseOptions и не теряется: интерпретатор дополняет его
+    runtime::Builtins host;
+    host.AddFunction("twice"s, {"x"s}, [](const vector<ObjectHolder>& args, runtime::Context&) {
+        return ObjectHolder::FromNumber(args[0].TryAs<runtime::Number>()->GetValue() * 2);
+    });
+    host.AddClass("Empty"s, {});
+
+    ostringstream output;
+    ParseOptions options;
+    options.builtins = &host;
+    Interpreter interpreter(output, options);
+    ASSERT(interpreter.GetBuiltins().GetParent() == &host);
+    interpreter.GetBuiltins().AddFunction("triple"s, {"x"s}, [](const vector<ObjectHolder>& args, runtime::Context&) {
+        return ObjectHolder::FromNumber(args[0].TryAs<runtime::Number>()->GetValue() * 3);
+    });
+    // Имена реестра приложения нельзя переопределить
+    ASSERT_THROWS(interpreter.GetBuiltins().AddFunction("twice"s, {"x"s}, {}), runtime_error);
+    ASSERT_THROWS(interpreter.GetBuiltins().AddClass("Empty"s, {}), runtime_error);
+
+    istringstream program("e = Empty()\nprint twice(5), triple(5)\n");
+    interpreter.Load(program);
+    ASSERT_EQUAL(output.str(), "10 15\n"s);
+    ASSERT_EQUAL(interpreter.CallFunction("twice"s, {ObjectHolder::Own(runtime::Number{4})})
+                     .TryAs<runtime::Number>()->GetValue(),
+                 8);
+}
+
+void TestNativeClasses() {
+    ostringstream output;
+    Interpreter interpreter(output);
+
+    vector<runtime::Method> methods;
+    methods.push_back({"__init__"s, {"start"s}, nullptr,
+                       [](runtime::ClassInstance& self, const vector<ObjectHolder>& args, runtime::Context&) {
+                           self.Fields()["value"s] = args[0];
+                           return ObjectHolder::None();
+                       }});
+    methods.push_back({"step"s, {}, nullptr,
+                       [](runtime::ClassInstance&, const vector<ObjectHolder>&, runtime::Context&) {
+                           return ObjectHolder::FromNumber(1);
+                       }});
+    methods.push_back({"next"s, {}, nullptr,
+                       [](runtime::ClassInstance& self, const vector<ObjectHolder>&, runtime::Context& context) {
+                           const int value = self.Fields().at("value"s).TryAs<runtime::Number>()->GetValue();
+                           const int step = self.Call("step"s, {}, context).TryAs<runtime::Number>()->GetValue();
+                           self.Fields()["value"s] = ObjectHolder::FromNumber(value + step);
+                           return self.Fields().at("value"s);
+                       }});
+    interpreter.GetBuiltins().AddClass("Counter"s, std::move(methods));
+
+    istringstream program(R"(
+class ByTwo(Counter):
+  def step():
+    return 2
+
+c = Counter(10)
+b = ByTwo(0)
+print c.next(), c.next(), b.next(), b.next(), c.value
+)");
+    interpreter.Load(program);
+    ASSERT_EQUAL(output.str(), "11 12 2 4 12\n"s);
+    ASSERT_EQUAL(interpreter.CallMethod("b"s, "next"s).TryAs<runtime::Number>()->GetValue(), 6);
+}
+
+void TestErrorPositions() {
+    ostringstream output;
+    Interpreter interpreter(output);
+
+    istringstream program(R"(
+class Account:
+  def withdraw(amount):
+    self.balance = self.balance - amount
+
+def ratio(a, b):
+  return a / b
+
+account = Account()
+)");
+    interpreter.Load(program);
+
+    try {
+        interpreter.CallFunction("ratio"s, {ObjectHolder::Own(runtime::Number{1}), ObjectHolder::Own(runtime::Number{0})});
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT_EQUAL(string(e.what()).substr(0, 18), "Line 7, column 3: "s);
+    }
+
+    try {
+        interpreter.CallMethod("account"s, "withdraw"s, {ObjectHolder::Own(runtime::Number{5})});
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT_EQUAL(string(e.what()).substr(0, 18), "Line 4, column 5: "s);
+    }
+
+    istringstream failing("x = 1\nprint x + 'a'\n");
+    try {
+        interpreter.Load(failing);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT_EQUAL(string(e.what()).substr(0, 18), "Line 2, column 1: "s);
+    }
+}
+
+void TestExecutionLimits() {
+    ostringstream output;
+    Interpreter interpreter(output);
+    istringstream program(R"(
+class Loop:
+  def forever():
+    while True:
+      x = 1
+
+  def recurse(n):
+    return self.recurse(n + 1)
+
+def grow(s):
+  while True:
+    s = s + s
+
+def append(n):
+  items = []
+  item = 'x'
+  for i in range(n):
+    items.append(item)
+  return n
+
+def insert(n):
+  items = {}
+  item = 'x'
+  for i in range(n):
+    items[i] = item
+  return n
+
+def count(n):
+  total = 0
+  for i in range(n):
+    total = total + i
+  return total
+
+loop = Loop()
+)");
+    interpreter.Load(program);
+    runtime::Context& context = interpreter.GetContext();
+
+    auto call_error = [&](const string& object, const string& method, const vector<ObjectHolder>& args) {
+        try {
+            if (object.empty()) {
+                interpreter.CallFunction(method, args);
+            } else {
+                interpreter.CallMethod(object, method, args);
+            }
+        } catch (const runtime::LimitError& e) {
+            return string(e.what());
+        }
+        return "no error"s;
+    };
+
+    runtime::ExecutionLimits limits;
+    limits.max_steps = 1000;
+    context.SetLimits(limits);
+    ASSERT_EQUAL(call_error("loop"s, "forever"s, {}), "Line 4, column 5: Step limit exceeded: 1000"s);
+    ASSERT_EQUAL(context.GetStepCount(), 1000u);
+    // Хвостовая рекурсия не растит стек, но каждый вызов считается шагом
+    context.SetLimits(limits);
+    ASSERT(call_error("loop"s, "recurse"s, {ObjectHolder::Own(runtime::Number{0})}).find("Step limit"s) != string::npos);
+
+    // Счётчик шагов начинается заново при каждом SetLimits, и интерпретатор продолжает работать
+    context.SetLimits(limits);
+    auto total = interpreter.CallFunction("count"s, {ObjectHolder::Own(runtime::Number{100})});
+    ASSERT_EQUAL(total.TryAs<runtime::Number>()->GetValue(), 4950);
+    ASSERT_EQUAL(context.GetStepCount(), 101u);
+
+    limits = {};
+    limits.max_heap_bytes = 1 << 20;
+    context.SetLimits(limits);
+    ASSERT(call_error({}, "grow"s, {ObjectHolder::Own(runtime::String{"ab"s})}).find("Memory limit exceeded"s)
+           != string::npos);
+    // Объекты прерванной программы удалены, и память снова доступна
+    ASSERT_EQUAL(context.GetHeapAccount()->GetUsedBytes(), 0u);
+
+    // Списки и словари учитывают память по мере роста, а не только при создании: здесь растёт
+    // только сам контейнер, в который добавляется один и тот же объект
+    limits = {};
+    limits.max_heap_bytes = 100000;
+    context.SetLimits(limits);
+    total = interpreter.CallFunction("append"s, {ObjectHolder::Own(runtime::Number{1000})});
+    ASSERT_EQUAL(total.TryAs<runtime::Number>()->GetValue(), 1000);
+    context.SetLimits(limits);
+    ASSERT(call_error({}, "append"s, {ObjectHolder::Own(runtime::Number{2000000})}).find("Memory limit exceeded"s)
+           != string::npos);
+    ASSERT_EQUAL(context.GetHeapAccount()->GetUsedBytes(), 0u);
+    context.SetLimits(limits);
+    ASSERT(call_error({}, "insert"s, {ObjectHolder::Own(runtime::Number{2000000})}).find("Memory limit exceeded"s)
+           != string::npos);
+    ASSERT_EQUAL(context.GetHeapAccount()->GetUsedBytes(), 0u);
+
+    limits = {};
+    limits.timeout = chrono::milliseconds(20);
+    context.SetLimits(limits);
+    ASSERT(call_error("loop"s, "forever"s, {}).find("Time limit exceeded: 20 ms"s) != string::npos);
+
+    context.SetLimits({});
+    total = interpreter.CallFunction("count"s, {ObjectHolder::Own(runtime::Number{10})});
+    ASSERT_EQUAL(total.TryAs<runtime::Number>()->GetValue(), 45);
+}
+
+}  // namespace
+
+void RunInterpreterTests(TestRunner& tr) {
+    RUN_TEST(tr, TestLoadAndCall);
+    RUN_TEST(tr, TestNativeFunctions);
+    RUN_TEST(tr, TestNativeClasses);
+    RUN_TEST(tr, TestHostBuiltins);
+    RUN_TEST(tr, TestErrorPositions);
+    RUN_TEST(tr, TestExecutionLimits);
+}
@@ -4,6 +4,7 @@
 #include <charconv>
 #include <unordered_map>
 #include <cctype>
+#include <iterator>
 
 
 using namespace std;
@@ -70,6 +71,11 @@ namespace parse {
         UNVALUED_OUTPUT(None);
         UNVALUED_OUTPUT(True);
         UNVALUED_OUTPUT(False);
+        UNVALUED_OUTPUT(While);
+        UNVALUED_OUTPUT(Break);
+        UNVALUED_OUTPUT(Continue);
+        UNVALUED_OUTPUT(For);
+        UNVALUED_OUTPUT(In);
         UNVALUED_OUTPUT(Eof);
 
 #undef UNVALUED_OUTPUT
@@ -77,10 +83,36 @@ namespace parse {
         return os << "Unknown token :("sv;
     }
 
+    std::string_view GetTokenTypeName(const Token& token) {
+        static constexpr std::string_view names[] = {
+            "Number"sv, "Id"sv, "Char"sv, "String"sv, "Class"sv, "Return"sv, "If"sv, "Else"sv,
+            "Def"sv, "Newline"sv, "Print"sv, "Indent"sv, "Dedent"sv, "And"sv, "Or"sv, "Not"sv,
+            "Eq"sv, "NotEq"sv, "LessOrEq"sv, "GreaterOrEq"sv, "None"sv, "True"sv, "False"sv, "While"sv,
+            "Break"sv, "Continue"sv, "For"sv, "In"sv, "Eof"sv,
+        };
+        static_assert(std::size(names) == std::variant_size_v<TokenBase>);
+        return names[token.index()];
+    }
+
+    std::string DescribePosition(const SourcePosition& position) {
+        return "Line "s + std::to_string(position.line) + ", column "s + std::to_string(position.column);
+    }
+
     Lexer::Lexer(std::istream& input):in_stream_(input)
     {
-        ParseInputStream(input);
-       
+        // Текст читается целиком, чтобы позиции токенов можно было вычислять по смещению
+        std::string source{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+        source_size_ = source.size();
+        line_starts_.push_back(0);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            if (source[i] == '\n')
+            {
+                line_starts_.push_back(i + 1);
+            }
+        }
+        std::istringstream source_stream(std::move(source));
+        ParseInputStream(source_stream);
     }
 
     const Token& Lexer::CurrentToken() const {
@@ -88,6 +120,69 @@ namespace parse {
         return *current_token_it_;
     }
 
+    const SourceSpan& Lexer::CurrentSpan() const {
+        return spans_[current_token_it_ - tokens_.begin()];
+    }
+
+    SourcePosition Lexer::PreviousTokenEnd() const {
+        const size_t index = current_token_it_ - tokens_.begin();
+        return index == 0 ? spans_[0].begin : spans_[index - 1].end;
+    }
+
+    void Lexer::ThrowUnexpectedToken(std::string_view expected) const {
+        std::ostringstream message;
+        message << DescribePosition(CurrentPosition()) << ": expected "sv << expected << ", found "sv
+                << CurrentToken();
+        throw LexerError(message.str());
+    }
+
+    size_t Lexer::GetOffset(std::istream& input) const {
+        // tellg() на потоке с установленным eofbit перевело бы его в состояние ошибки,
+        // а eofbit устанавливается только в конце текста
+        if (!input.good())
+        {
+            return source_size_;
+        }
+        return static_cast<size_t>(input.tellg());
+    }
+
+    SourcePosition Lexer::ToPosition(size_t offset) const {
+        const auto line_it = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset) - 1;
+        return {static_cast<uint32_t>(line_it - line_starts_.begin() + 1),
+                static_cast<uint32_t>(offset - *line_it + 1)};
+    }
+
+    void Lexer::ParseTracked(std::istream& input, void (Lexer::*parse)(std::istream&)) {
+        const size_t begin = GetOffset(input);
+        const size_t token_count = tokens_.size();
+        try
+        {
+            (this->*parse)(input);
+        }
+        catch (const LexerError& e)
+        {
+            throw LexerError(DescribePosition(ToPosition(begin)) + ": "s + e.what());
+        }
+        const SourceSpan span{ToPosition(begin), ToPosition(GetOffset(input))};
+        for (size_t i = token_count; i < tokens_.size(); ++i)
+        {
+            // Отступ относится к началу следующей строки, а не к концу предыдущей.
+            // Перевод строки не входит в участки инструкций, которые он завершает
+            if (tokens_[i].Is<token_type::Indent>() || tokens_[i].Is<token_type::Dedent>())
+            {
+                spans_.push_back({span.end, span.end});
+            }
+            else if (tokens_[i].Is<token_type::Newline>())
+            {
+                spans_.push_back({span.begin, span.begin});
+            }
+            else
+            {
+                spans_.push_back(span);
+            }
+        }
+    }
+
     Token Lexer::NextToken() {
         if ((current_token_it_ + 1) == tokens_.end())
         {          
@@ -171,15 +266,16 @@ namespace parse {
     void Lexer::ParseInputStream(std::istream& input) {
         global_indent_counter_ = 0;
         tokens_.clear();
+        spans_.clear();
         current_token_it_ = tokens_.begin();
         TrimSpaces(input);
         while (input) {
-            ParseString(input);
-            ParseKeywords(input);
-            ParseChars(input);
-            ParseNumbers(input);
+            ParseTracked(input, &Lexer::ParseString);
+            ParseTracked(input, &Lexer::ParseKeywords);
+            ParseTracked(input, &Lexer::ParseChars);
+            ParseTracked(input, &Lexer::ParseNumbers);
             TrimSpaces(input);
-            ParseNewLine(input);
+            ParseTracked(input, &Lexer::ParseNewLine);
         }
         // перед Eof должен всешда быть Newline
         if (!tokens_.empty() && (!tokens_.back().Is<token_type::Newline>()))
@@ -194,6 +290,9 @@ namespace parse {
             --global_indent_counter_;
         }
         tokens_.emplace_back(token_type::Eof{});
+        // Завершающие токены относятся к концу текста
+        const SourcePosition end = ToPosition(source_size_);
+        spans_.resize(tokens_.size(), SourceSpan{end, end});
         current_token_it_ = tokens_.begin();
     }
 
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <map>
 #include <vector>
@@ -50,6 +52,11 @@ namespace parse {
         struct None {};         // Лексема «None»
         struct True {};         // Лексема «True»
         struct False {};        // Лексема «False»
+        struct While {};        // Лексема «while»
+        struct Break {};        // Лексема «break»
+        struct Continue {};     // Лексема «continue»
+        struct For {};          // Лексема «for»
+        struct In {};           // Лексема «in»
     }  // namespace token_type
 
     using TokenBase
@@ -58,7 +65,9 @@ namespace parse {
         token_type::Def, token_type::Newline, token_type::Print, token_type::Indent,
         token_type::Dedent, token_type::And, token_type::Or, token_type::Not,
         token_type::Eq, token_type::NotEq, token_type::LessOrEq, token_type::GreaterOrEq,
-        token_type::None, token_type::True, token_type::False, token_type::Eof>;
+        token_type::None, token_type::True, token_type::False, token_type::While,
+        token_type::Break, token_type::Continue, token_type::For, token_type::In,
+        token_type::Eof>;
 
     struct Token : TokenBase {
         using TokenBase::TokenBase;
@@ -84,6 +93,24 @@ namespace parse {
 
     std::ostream& operator<<(std::ostream& os, const Token& rhs);
 
+    // Возвращает название типа лексемы без значения, например "Id" или "Newline"
+    std::string_view GetTokenTypeName(const Token& token);
+
+    // Позиция в исходном тексте. Строки и столбцы нумеруются с 1, нулевая строка - позиция неизвестна
+    struct SourcePosition {
+        uint32_t line = 0;
+        uint32_t column = 0;
+    };
+
+    // Участок исходного текста: begin - первый символ, end - позиция за последним символом
+    struct SourceSpan {
+        SourcePosition begin;
+        SourcePosition end;
+    };
+
+    // Возвращает описание позиции для сообщений об ошибках: "Line 3, column 7"
+    std::string DescribePosition(const SourcePosition& position);
+
     class LexerError : public std::runtime_error {
     public:
         using std::runtime_error::runtime_error;
@@ -99,15 +126,21 @@ namespace parse {
         // Возвращает следующий токен, либо token_type::Eof, если поток токенов закончился
         Token NextToken();
 
+        // Возвращает участок исходного текста, занимаемый текущим токеном
+        [[nodiscard]] const SourceSpan& CurrentSpan() const;
+        [[nodiscard]] SourcePosition CurrentPosition() const {
+            return CurrentSpan().begin;
+        }
+        // Возвращает позицию за концом токена, предшествующего текущему
+        [[nodiscard]] SourcePosition PreviousTokenEnd() const;
+
         // Если текущий токен имеет тип T, метод возвращает ссылку на него.
         // В противном случае метод выбрасывает исключение LexerError
         template <typename T>
         const T& Expect() const {
-            using namespace std::literals;
-            // Заглушка. Реализуйте метод самостоятельно
             if (!(*current_token_it_).Is<T>())
             {
-                throw LexerError("Token::Expect() method has failed."s);
+                ThrowUnexpectedToken(GetTokenTypeName(T{}));
             }
             return CurrentToken().As<T>();
         }
@@ -116,11 +149,12 @@ namespace parse {
         // В противном случае метод выбрасывает исключение LexerError
         template <typename T, typename U>
         void Expect(const U& value) const {
-            using namespace std::literals;          
             Token other_token(T{ value }); // делаем из value токен типа T          
             if (*current_token_it_ != other_token)
             {
-                throw LexerError("Token::Expect(value) method has failed."s);
+                std::ostringstream expected;
+                expected << other_token;
+                ThrowUnexpectedToken(expected.str());
             }
         }
 
@@ -158,10 +192,18 @@ namespace parse {
             {std::string{"not"},token_type::Not{}},
             {std::string{"None"},token_type::None{}},
             {std::string{"True"},token_type::True{}},
-            {std::string{"False"},token_type::False{}}
+            {std::string{"False"},token_type::False{}},
+            {std::string{"while"},token_type::While{}},
+            {std::string{"break"},token_type::Break{}},
+            {std::string{"continue"},token_type::Continue{}},
+            {std::string{"for"},token_type::For{}},
+            {std::string{"in"},token_type::In{}}
         };
 
         std::vector<Token> tokens_; //разобранные токены
+        std::vector<SourceSpan> spans_; // участки исходного текста токенов, по индексу токена
+        std::vector<size_t> line_starts_; // смещения начал строк исходного текста
+        size_t source_size_ = 0;
         std::vector<Token>::const_iterator current_token_it_; // итератор не текущий токен
         const std::istream& in_stream_;// входной поток для разбора
 
@@ -176,6 +218,13 @@ namespace parse {
         void ParseNumbers(std::istream& istr);
         void ParseNewLine(std::istream& istr);
         void ParseComments(std::istream& istr);       
+
+        // Смещение текущего символа входного потока от начала текста
+        size_t GetOffset(std::istream& istr) const;
+        SourcePosition ToPosition(size_t offset) const;
+        // Вызывает parse и запоминает участок текста, прочитанный им, для добавленных токенов
+        void ParseTracked(std::istream& istr, void (Lexer::*parse)(std::istream&));
+        [[noreturn]] void ThrowUnexpectedToken(std::string_view expected) const;
     
     };
 
@@ -40,6 +40,19 @@ void TestKeywords() {
     ASSERT_EQUAL(lexer.NextToken(), Token(token_type::False{}));
 }
 
+void TestLoopKeywords() {
+    istringstream input("while break continue whiles for in range"s);
+    Lexer lexer(input);
+
+    ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::While{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Break{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Continue{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"whiles"s}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::For{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::In{}));
+    ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{"range"s}));
+}
+
 void TestNumbers() {
     istringstream input("42 15 -53"s);
     Lexer lexer(input);
@@ -295,6 +308,44 @@ void TestExpectNext() {
     ASSERT_THROWS(lex.ExpectNext<token_type::Number>(57), LexerError);
 }
 
+void TestTokenPositions() {
+    istringstream is("x = 'ab'\nif x:\n  print 42\n"s);
+    Lexer lex(is);
+
+    auto check_span = [&lex](uint32_t line, uint32_t begin, uint32_t end) {
+        ASSERT_EQUAL(lex.CurrentSpan().begin.line, line);
+        ASSERT_EQUAL(lex.CurrentSpan().begin.column, begin);
+        ASSERT_EQUAL(lex.CurrentSpan().end.line, line);
+        ASSERT_EQUAL(lex.CurrentSpan().end.column, end);
+    };
+
+    check_span(1, 1, 2);  // x
+    lex.NextToken();
+    check_span(1, 3, 4);  // =
+    lex.NextToken();
+    check_span(1, 5, 9);  // 'ab'
+    lex.NextToken();
+    lex.NextToken();
+    check_span(2, 1, 3);  // if
+    ASSERT_EQUAL(lex.PreviousTokenEnd().line, 1u);
+    lex.NextToken();
+    lex.NextToken();
+    check_span(2, 5, 6);  // :
+    lex.NextToken();
+    lex.NextToken();
+    lex.NextToken();
+    check_span(3, 3, 8);  // print
+    lex.NextToken();
+    check_span(3, 9, 11);  // 42
+
+    try {
+        lex.Expect<token_type::Id>();
+        ASSERT(false);
+    } catch (const LexerError& e) {
+        ASSERT_EQUAL(string(e.what()), "Line 3, column 9: expected Id, found Number{42}"s);
+    }
+}
+
 void TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine() {
     {
         istringstream is("a b"s);
@@ -356,6 +407,7 @@ abc#
 void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestSimpleAssignment);
     RUN_TEST(tr, parse::TestKeywords);
+    RUN_TEST(tr, parse::TestLoopKeywords);
     RUN_TEST(tr, parse::TestNumbers);
     RUN_TEST(tr, parse::TestIds);
     RUN_TEST(tr, parse::TestStrings);
@@ -364,6 +416,7 @@ void RunOpenLexerTests(TestRunner& tr) {
     RUN_TEST(tr, parse::TestEmptyLinesAreIgnored);
     RUN_TEST(tr, parse::TestExpect);
     RUN_TEST(tr, parse::TestExpectNext);
+    RUN_TEST(tr, parse::TestTokenPositions);
     RUN_TEST(tr, parse::TestMythonProgram);
     RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
     RUN_TEST(tr, parse::TestCommentsAreIgnored);
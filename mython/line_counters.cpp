@@ -0,0 +1,54 @@
+#include "line_counters.h"
+
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        vector<string_view> SplitLines(string_view text) {
+            vector<string_view> lines;
+            while (!text.empty())
+            {
+                const size_t end = text.find('\n');
+                lines.push_back(text.substr(0, end));
+                text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+            }
+            return lines;
+        }
+    }  // namespace
+
+    void LineCounters::WriteReport(ostream& out, string_view source) const {
+        const vector<string_view> source_lines = SplitLines(source);
+
+        uint64_t total_count = 0;
+        for (const auto& [line, counter] : lines_)
+        {
+            total_count += counter.count.load(memory_order_relaxed);
+        }
+
+        out << "Lines: "sv << lines_.size() << ", statements executed: "sv << total_count << '\n';
+        out << setw(8) << "line"sv << setw(14) << "count"sv << setw(14) << "time, ms"sv;
+        if (!source_lines.empty())
+        {
+            out << "  source"sv;
+        }
+        out << '\n';
+
+        for (const auto& [line, counter] : lines_)
+        {
+            const double ms = static_cast<double>(counter.nanoseconds.load(memory_order_relaxed)) / 1e6;
+            out << setw(8) << line << setw(14) << counter.count.load(memory_order_relaxed) << setw(14) << fixed
+                << setprecision(3) << ms;
+            if (line >= 1 && line <= source_lines.size())
+            {
+                out << "  "sv << source_lines[line - 1];
+            }
+            out << '\n';
+        }
+    }
+
+}  // namespace ast
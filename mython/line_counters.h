@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string_view>
+
+namespace ast {
+
+    // Счётчики одной строки программы: число выполненных инструкций, начинающихся в строке,
+    // и суммарное время их выполнения вместе с вложенными инструкциями
+    struct LineCounter {
+        std::atomic<uint64_t> count = 0;
+        std::atomic<uint64_t> nanoseconds = 0;
+    };
+
+    /*
+     * Счётчики выполнения инструкций по строкам исходного текста.
+     *
+     * Если счётчики переданы в ParseOptions::line_counters, парсер оборачивает каждую инструкцию
+     * узлом CountedStatement, который увеличивает счётчик её строки. Без счётчиков дерево
+     * строится как обычно, поэтому выключенный подсчёт ничего не стоит.
+     * Счётчики атомарны, так что одно дерево можно выполнять одновременно в нескольких потоках
+     */
+    class LineCounters {
+    public:
+        // Возвращает счётчик строки line. Адрес счётчика не меняется, пока существует объект
+        LineCounter& GetLine(uint32_t line) {
+            return lines_[line];
+        }
+
+        [[nodiscard]] const std::map<uint32_t, LineCounter>& GetLines() const {
+            return lines_;
+        }
+
+        // Выводит по строке на каждую выполнявшуюся строку программы: номер, число выполнений,
+        // время в миллисекундах и, если передан исходный текст source, саму строку
+        void WriteReport(std::ostream& out, std::string_view source = {}) const;
+
+    private:
+        std::map<uint32_t, LineCounter> lines_;
+    };
+
+}  // namespace ast
@@ -0,0 +1,103 @@
+#include "interpreter.h"
+#include "line_counters.h"
+#include "test_runner.h"
+
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+const string COUNTED_PROGRAM = R"(total = 0
+for i in range(5):
+  if i == 3:
+    continue
+  total = total + i
+
+def half(x):
+  return x / 2
+
+while True:
+  total = total + half(total)
+  break
+if False:
+  print 'never'
+print total
+)"s;
+
+uint64_t GetCount(const ast::LineCounters& counters, uint32_t line) {
+    const auto it = counters.GetLines().find(line);
+    return it == counters.GetLines().end() ? 0 : it->second.count.load();
+}
+
+void TestLineCounts() {
+    for (const bool optimize : {false, true}) {
+        ast::LineCounters counters;
+        ParseOptions options;
+        options.optimize = optimize;
+        options.line_counters = &counters;
+        ostringstream output;
+        Interpreter interpreter(output, options);
+        istringstream program(COUNTED_PROGRAM);
+        interpreter.Load(program);
+
+        ASSERT_EQUAL(output.str(), "10\n"s);
+        ASSERT_EQUAL(GetCount(counters, 1), 1u);
+        ASSERT_EQUAL(GetCount(counters, 2), 1u);
+        ASSERT_EQUAL(GetCount(counters, 3), 5u);
+        // continue и return завершают инструкцию исключением, но тоже учитываются
+        ASSERT_EQUAL(GetCount(counters, 4), 1u);
+        ASSERT_EQUAL(GetCount(counters, 5), 4u);
+        ASSERT_EQUAL(GetCount(counters, 7), 1u);
+        ASSERT_EQUAL(GetCount(counters, 8), 1u);
+        ASSERT_EQUAL(GetCount(counters, 11), 1u);
+        ASSERT_EQUAL(GetCount(counters, 12), 1u);
+        ASSERT_EQUAL(GetCount(counters, 13), 1u);
+        ASSERT_EQUAL(GetCount(counters, 14), 0u);
+        ASSERT_EQUAL(GetCount(counters, 15), 1u);
+        // Время строки включает время вложенных инструкций
+        ASSERT(counters.GetLines().at(2).nanoseconds.load() >= counters.GetLines().at(5).nanoseconds.load());
+    }
+}
+
+void TestRuntimeErrorIsCounted() {
+    ast::LineCounters counters;
+    ParseOptions options;
+    options.line_counters = &counters;
+    ostringstream output;
+    Interpreter interpreter(output, options);
+    istringstream program("x = 1\nprint x + 'a'\nprint x\n"s);
+
+    try {
+        interpreter.Load(program);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        // Счётчики не мешают определять позицию ошибки
+        ASSERT_EQUAL(string(e.what()).substr(0, 18), "Line 2, column 1: "s);
+    }
+    ASSERT_EQUAL(GetCount(counters, 1), 1u);
+    ASSERT_EQUAL(GetCount(counters, 2), 1u);
+    ASSERT_EQUAL(GetCount(counters, 3), 0u);
+}
+
+void TestLineReport() {
+    ast::LineCounters counters;
+    counters.GetLine(1).count = 3;
+    counters.GetLine(1).nanoseconds = 2'500'000;
+    counters.GetLine(3).count = 1;
+
+    ostringstream report;
+    counters.WriteReport(report, "x = 1\n\nprint x\n"s);
+    ASSERT_EQUAL(report.str(), "Lines: 2, statements executed: 4\n"
+                               "    line         count      time, ms  source\n"
+                               "       1             3         2.500  x = 1\n"
+                               "       3             1         0.000  print x\n"s);
+}
+
+}  // namespace
+
+void RunLineCounterTests(TestRunner& tr) {
+    RUN_TEST(tr, TestLineCounts);
+    RUN_TEST(tr, TestRuntimeErrorIsCounted);
+    RUN_TEST(tr, TestLineReport);
+}
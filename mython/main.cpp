@@ -1,140 +1,216 @@
-#include "lexer.h"
+#include "async_output.h"
+#include "command_line.h"
+#include "interpreter.h"
+#include "line_counters.h"
 #include "parse.h"
+#include "profiler.h"
+#include "record_output.h"
 #include "runtime.h"
-#include "statement.h"
-#include "test_runner.h"
+#include "statistics.h"
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <sstream>
 
 using namespace std;
 
-namespace parse {
-void RunOpenLexerTests(TestRunner& tr);
-}  // namespace parse
-
-//namespace ast {
-//void RunUnitTests(TestRunner& tr);
-//}
-namespace runtime {
-void RunObjectHolderTests(TestRunner& tr);
-void RunObjectsTests(TestRunner& tr);
-}  // namespace runtime
-
-void TestParseProgram(TestRunner& tr);
-
 namespace {
 
-void RunMythonProgram(istream& input, ostream& output) {
-    parse::Lexer lexer(input);
-    auto program = ParseProgram(lexer);
-
-    runtime::SimpleContext context{output};
-    runtime::Closure closure;
-    program->Execute(closure, context);
+// Записывает свёрнутые стеки в файл path, а таблицу времени методов - в поток ошибок
+void WriteProfile(const runtime::Profiler& profiler, const string& path) {
+    ofstream folded(path);
+    if (!folded) {
+        std::cerr << "Cannot write profile to "sv << path << std::endl;
+    } else {
+        profiler.WriteFoldedStacks(folded);
+    }
+    profiler.WriteReport(std::cerr);
 }
 
-void TestSimplePrints() {
-    istringstream input(R"(
-print 57
-print 10, 24, -8
-print 'hello'
-print "world"
-print True, False
-print
-print None
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\n10 24 -8\nhello\nworld\nTrue False\n\nNone\n");
+// Записывает в файл path число выполнений и время каждой строки программы source
+void WriteLineProfile(const ast::LineCounters& line_counters, const string& source, const string& path) {
+    ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write line profile to "sv << path << std::endl;
+        return;
+    }
+    line_counters.WriteReport(out, source);
 }
 
-void TestAssignments() {
-    istringstream input(R"(
-x = 57
-print x
-x = 'C++ black belt'
-print x
-y = False
-x = y
-print x
-x = None
-print x, y
-)");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
-
-    ASSERT_EQUAL(output.str(), "57\nC++ black belt\nFalse\nNone False\n");
+// Записывает статистику выполнения в файл path в формате JSON
+void WriteStatistics(const runtime::Statistics& statistics, const string& path) {
+    ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write statistics to "sv << path << std::endl;
+        return;
+    }
+    statistics.WriteJson(out);
 }
 
-void TestArithmetics() {
-    istringstream input("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2");
-
-    ostringstream output;
-    RunMythonProgram(input, output);
+struct RunOptions {
+    ParseOptions parse;
+    size_t max_call_depth = runtime::Context::DEFAULT_MAX_CALL_DEPTH;
+    runtime::ExecutionLimits limits;
+    // Если задана, статистика собирается во время выполнения программы
+    runtime::Statistics* statistics = nullptr;
+    // Если задан, print выводит значения в двоичном формате (см. record_output.h)
+    runtime::RecordWriter* record_writer = nullptr;
+    // Если задан, программа выполняется под профилировщиком, а профиль записывается
+    // в profile_path, пока классы и функции программы ещё существуют, в том числе при ошибке
+    runtime::Profiler* profiler = nullptr;
+    string profile_path;
+};
+
+void RunMythonProgram(istream& input, ostream& output, const RunOptions& options) {
+    Interpreter interpreter(output, options.parse);
+    interpreter.GetContext().SetMaxCallDepth(options.max_call_depth);
+    interpreter.GetContext().SetStatistics(options.statistics);
+    interpreter.GetContext().SetRecordWriter(options.record_writer);
+    runtime::Profiler* profiler = options.profiler;
+    if (profiler == nullptr) {
+        interpreter.GetContext().SetLimits(options.limits);
+        interpreter.Load(input);
+        return;
+    }
 
-    ASSERT_EQUAL(output.str(), "15 120 -13 3 15\n");
+    interpreter.GetContext().SetProfiler(profiler);
+    auto finish_profile = [&] {
+        profiler->Stop();
+        output.flush();
+        WriteProfile(*profiler, options.profile_path);
+    };
+    profiler->Start();
+    interpreter.GetContext().SetLimits(options.limits);
+    try {
+        interpreter.Load(input);
+    } catch (...) {
+        finish_profile();
+        throw;
+    }
+    finish_profile();
 }
 
-void TestVariablesArePointers() {
-    istringstream input(R"(
-class Counter:
-  def __init__():
-    self.value = 0
-
-  def add():
-    self.value = self.value + 1
-
-class Dummy:
-  def do_add(counter):
-    counter.add()
-
-x = Counter()
-y = x
-
-x.add()
-y.add()
-
-print x.value
-
-d = Dummy()
-d.do_add(x)
-
-print y.value
-)");
+}  // namespace
 
-    ostringstream output;
-    RunMythonProgram(input, output);
+int main(int argc, char* argv[]) {
+    const auto recursion_limit_option = "--recursion-limit="sv;
+    const auto profile_option = "--profile="sv;
+    const auto profile_interval_option = "--profile-interval-us="sv;
+    const auto line_profile_option = "--line-profile="sv;
+    const auto stats_option = "--stats="sv;
+    const auto max_steps_option = "--max-steps="sv;
+    const auto max_heap_option = "--max-heap-bytes="sv;
+    const auto timeout_option = "--timeout-ms="sv;
+
+    RunOptions options;
+    uint32_t profile_interval_us = 1000;
+    string line_profile_path;
+    string stats_path;
+    bool async_output = false;
+    runtime::RecordWriter record_writer;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg.substr(0, recursion_limit_option.size()) == recursion_limit_option) {
+            const auto depth = ParseOptionValue<size_t>(arg.substr(recursion_limit_option.size()));
+            if (!depth) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            options.max_call_depth = *depth;
+        } else if (arg.substr(0, max_steps_option.size()) == max_steps_option) {
+            const auto steps = ParseOptionValue<uint64_t>(arg.substr(max_steps_option.size()));
+            if (!steps) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            options.limits.max_steps = *steps;
+        } else if (arg.substr(0, max_heap_option.size()) == max_heap_option) {
+            const auto bytes = ParseOptionValue<size_t>(arg.substr(max_heap_option.size()));
+            if (!bytes) {
+                return ReportInvalidOption(arg, "a non-negative integer"sv);
+            }
+            options.limits.max_heap_bytes = *bytes;
+        } else if (arg.substr(0, timeout_option.size()) == timeout_option) {
+            const auto timeout = ParseOptionMilliseconds(arg.substr(timeout_option.size()));
+            if (!timeout) {
+                return ReportInvalidOption(arg, "a non-negative number of milliseconds"sv);
+            }
+            options.limits.timeout = *timeout;
+        } else if (arg.substr(0, profile_option.size()) == profile_option) {
+            options.profile_path = arg.substr(profile_option.size());
+        } else if (arg.substr(0, line_profile_option.size()) == line_profile_option) {
+            line_profile_path = arg.substr(line_profile_option.size());
+        } else if (arg.substr(0, stats_option.size()) == stats_option) {
+            stats_path = arg.substr(stats_option.size());
+        } else if (arg.substr(0, profile_interval_option.size()) == profile_interval_option) {
+            const auto interval = ParseOptionValue<uint32_t>(arg.substr(profile_interval_option.size()));
+            if (!interval || *interval == 0) {
+                return ReportInvalidOption(arg, "a positive number of microseconds"sv);
+            }
+            profile_interval_us = *interval;
+        } else if (arg == "--no-optimize"sv) {
+            options.parse.optimize = false;
+        } else if (arg == "--async-output"sv) {
+            async_output = true;
+        } else if (arg == "--binary-output"sv) {
+            options.record_writer = &record_writer;
+        } else {
+            std::cerr << "Unknown option: "sv << argv[i] << std::endl;
+            return 1;
+        }
+    }
 
-    ASSERT_EQUAL(output.str(), "2\n3\n");
-}
+    // Для отчёта по строкам текст программы нужен целиком, поэтому он читается заранее
+    ast::LineCounters line_counters;
+    string source;
+    istringstream source_input;
+    istream* input = &cin;
+    if (!line_profile_path.empty()) {
+        source.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        source_input.str(source);
+        input = &source_input;
+        options.parse.line_counters = &line_counters;
+    }
 
-void TestAll() {
-    TestRunner tr;
-    parse::RunOpenLexerTests(tr);
-    runtime::RunObjectHolderTests(tr);
-    runtime::RunObjectsTests(tr);
-    //ast::RunUnitTests(tr);
-    TestParseProgram(tr);
-
-    RUN_TEST(tr, TestSimplePrints);
-    RUN_TEST(tr, TestAssignments);
-    RUN_TEST(tr, TestArithmetics);
-    RUN_TEST(tr, TestVariablesArePointers);
-}
+    runtime::Statistics statistics;
+    if (!stats_path.empty()) {
+        statistics.Start(cout);
+        options.statistics = &statistics;
+    }
 
-}  // namespace
+    // Вывод программы записывается в cout отдельным потоком. Перед сообщением об ошибке
+    // и отчётами он дописывается до конца
+    optional<runtime::AsyncOutputContext> async_context;
+    if (async_output) {
+        async_context.emplace(cout);
+    }
+    ostream& output = async_context ? async_context->GetOutputStream() : cout;
 
-int main() {
+    int exit_code = 0;
     try {
-        TestAll();
-
-        RunMythonProgram(cin, cout);
+        optional<runtime::Profiler> profiler;
+        if (!options.profile_path.empty()) {
+            profiler.emplace(chrono::microseconds(profile_interval_us));
+            options.profiler = &*profiler;
+        }
+        RunMythonProgram(*input, output, options);
     } catch (const std::exception& e) {
+        if (async_context) {
+            async_context->Flush();
+        }
         std::cerr << e.what() << std::endl;
-		return 1;
+        exit_code = 1;
+    }
+    if (async_context) {
+        async_context->Flush();
+    }
+    if (!stats_path.empty()) {
+        statistics.Stop();
+        WriteStatistics(statistics, stats_path);
+    }
+    if (!line_profile_path.empty()) {
+        cout.flush();
+        WriteLineProfile(line_counters, source, line_profile_path);
     }
-    return 0;
+    return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,450 @@
+#include "optimizer.h"
+
+#include "source_map.h"
+
+using namespace std;
+
+namespace ast {
+
+    using runtime::ObjectHolder;
+
+    namespace {
+        // Возвращает true, если stmt - константа, значение которой известно на этапе разбора
+        bool IsConstant(const Statement* stmt) {
+            return dynamic_cast<const NumericConst*>(stmt) != nullptr
+                || dynamic_cast<const StringConst*>(stmt) != nullptr
+                || dynamic_cast<const BoolConst*>(stmt) != nullptr
+                || dynamic_cast<const None*>(stmt) != nullptr;
+        }
+
+        // Возвращает true, если stmt - числовая константа, равная value
+        bool IsNumericConst(const Statement* stmt, int value) {
+            auto num_ptr = dynamic_cast<const NumericConst*>(stmt);
+            return num_ptr != nullptr && num_ptr->GetValue().GetValue() == value;
+        }
+
+        // Возвращает true, если результат stmt - всегда число (либо stmt выбрасывает исключение).
+        // Сложение сюда не входит: оно определено и для строк, и для пользовательских классов
+        bool IsNumeric(const Statement* stmt) {
+            return dynamic_cast<const NumericConst*>(stmt) != nullptr
+                || dynamic_cast<const Sub*>(stmt) != nullptr
+                || dynamic_cast<const Mult*>(stmt) != nullptr
+                || dynamic_cast<const Div*>(stmt) != nullptr
+                || dynamic_cast<const Negate*>(stmt) != nullptr;
+        }
+
+        template <runtime::CompareOp... Ops>
+        bool IsAnyCompareOperation(const Statement* stmt) {
+            return ((dynamic_cast<const CompareOperation<Ops>*>(stmt) != nullptr) || ...);
+        }
+
+        // Возвращает true, если результат stmt - всегда значение типа Bool
+        bool IsBoolean(const Statement* stmt) {
+            using runtime::CompareOp;
+            return dynamic_cast<const BoolConst*>(stmt) != nullptr
+                || dynamic_cast<const Not*>(stmt) != nullptr
+                || dynamic_cast<const And*>(stmt) != nullptr
+                || dynamic_cast<const Or*>(stmt) != nullptr
+                || dynamic_cast<const Comparison*>(stmt) != nullptr
+                || dynamic_cast<const Contains*>(stmt) != nullptr
+                || IsAnyCompareOperation<CompareOp::Less, CompareOp::Greater, CompareOp::Equal,
+                    CompareOp::NotEqual, CompareOp::LessOrEqual, CompareOp::GreaterOrEqual>(stmt);
+        }
+
+        // Возвращает true, если stmt - операция, которую можно вычислить на этапе разбора,
+        // когда все её аргументы - константы
+        bool IsFoldable(const Statement* stmt) {
+            return dynamic_cast<const Add*>(stmt) != nullptr
+                || IsNumeric(stmt)
+                || IsBoolean(stmt)
+                || dynamic_cast<const Stringify*>(stmt) != nullptr
+                || dynamic_cast<const Len*>(stmt) != nullptr;
+        }
+
+        // Создаёт константу со значением value либо возвращает nullptr,
+        // если значение такого типа не может быть константой
+        unique_ptr<Statement> MakeConstant(const ObjectHolder& value) {
+            if (!value)
+            {
+                return make_unique<None>();
+            }
+            if (auto num_ptr = value.TryAs<runtime::Number>())
+            {
+                return make_unique<NumericConst>(num_ptr->GetValue());
+            }
+            if (auto str_ptr = value.TryAs<runtime::String>())
+            {
+                return make_unique<StringConst>(str_ptr->GetValue());
+            }
+            if (auto bool_ptr = value.TryAs<runtime::Bool>())
+            {
+                return make_unique<BoolConst>(runtime::Bool{ bool_ptr->GetValue() });
+            }
+            return nullptr;
+        }
+    }  // namespace
+
+    class Optimizer {
+    public:
+        explicit Optimizer(parse::SourceMap* source_map)
+            : source_map_(source_map) {
+        }
+
+        unique_ptr<Statement> Run(unique_ptr<Statement> stmt) {
+            Visit(stmt);
+            return stmt;
+        }
+
+    private:
+        // Заменяет stmt новым узлом node, который занимает тот же участок исходного текста
+        void Replace(unique_ptr<Statement>& stmt, unique_ptr<Statement> node) {
+            if (source_map_ != nullptr)
+            {
+                if (const parse::SourceSpan* span = source_map_->Find(stmt.get()))
+                {
+                    source_map_->Set(node.get(), *span);
+                }
+            }
+            stmt = std::move(node);
+        }
+
+        // Оптимизирует выражение stmt, заменяя его при необходимости новым узлом
+        void Visit(unique_ptr<Statement>& stmt) {
+            if (!stmt)
+            {
+                return;
+            }
+            Statement* node = stmt.get();
+
+            if (auto ptr = dynamic_cast<Assignment*>(node))
+            {
+                Visit(ptr->rv_);
+            }
+            else if (auto ptr = dynamic_cast<FieldAssignment*>(node))
+            {
+                Visit(ptr->rv_);
+            }
+            else if (auto ptr = dynamic_cast<IndexAssignment*>(node))
+            {
+                Visit(ptr->object_);
+                Visit(ptr->index_);
+                Visit(ptr->rv_);
+            }
+            else if (auto ptr = dynamic_cast<ListLiteral*>(node))
+            {
+                VisitAll(ptr->elements_);
+            }
+            else if (auto ptr = dynamic_cast<DictLiteral*>(node))
+            {
+                for (auto& [key, value] : ptr->items_)
+                {
+                    Visit(key);
+                    Visit(value);
+                }
+            }
+            else if (auto ptr = dynamic_cast<CountedStatement*>(node))
+            {
+                Visit(ptr->statement_);
+            }
+            else if (auto ptr = dynamic_cast<Print*>(node))
+            {
+                VisitAll(ptr->args_);
+            }
+            else if (auto ptr = dynamic_cast<MethodCall*>(node))
+            {
+                Visit(ptr->object_);
+                VisitAll(ptr->args_);
+            }
+            else if (auto ptr = dynamic_cast<FunctionCall*>(node))
+            {
+                VisitAll(ptr->args_);
+            }
+            else if (auto ptr = dynamic_cast<TailReturn*>(node))
+            {
+                if (ptr->function_call_)
+                {
+                    VisitAll(ptr->function_call_->args_);
+                }
+                else
+                {
+                    Visit(ptr->call_->object_);
+                    VisitAll(ptr->call_->args_);
+                }
+            }
+            else if (auto ptr = dynamic_cast<NewInstance*>(node))
+            {
+                VisitAll(ptr->args_);
+            }
+            else if (auto ptr = dynamic_cast<Compound*>(node))
+            {
+                VisitAll(ptr->statements_);
+            }
+            else if (auto ptr = dynamic_cast<MethodBody*>(node))
+            {
+                Visit(ptr->body_);
+            }
+            else if (auto ptr = dynamic_cast<Return*>(node))
+            {
+                Visit(ptr->statement_);
+            }
+            else if (auto ptr = dynamic_cast<IfElse*>(node))
+            {
+                VisitCondition(ptr->condition_);
+                const size_t if_definitions = CountDefinitions(ptr->if_body_);
+                const size_t else_definitions = CountDefinitions(ptr->else_body_);
+                SimplifyIfElse(stmt, *ptr, if_definitions != 0, else_definitions != 0);
+            }
+            else if (auto ptr = dynamic_cast<While*>(node))
+            {
+                VisitCondition(ptr->condition_);
+                if (CountDefinitions(ptr->body_) == 0)
+                {
+                    SimplifyWhile(stmt, *ptr);
+                }
+            }
+            else if (dynamic_cast<ClassDefinition*>(node) != nullptr)
+            {
+                ++definition_count_;
+            }
+            else if (auto ptr = dynamic_cast<For*>(node))
+            {
+                Visit(ptr->start_);
+                Visit(ptr->stop_);
+                Visit(ptr->step_);
+                Visit(ptr->body_);
+            }
+            else if (dynamic_cast<Not*>(node) != nullptr)
+            {
+                auto& operation = static_cast<UnaryOperation&>(*node);
+                VisitCondition(operation.argument_);
+                FoldOrSimplify(stmt);
+            }
+            else if (dynamic_cast<And*>(node) != nullptr || dynamic_cast<Or*>(node) != nullptr)
+            {
+                auto& operation = static_cast<BinaryOperation&>(*node);
+                VisitCondition(operation.lhs_);
+                VisitCondition(operation.rhs_);
+                FoldOrSimplify(stmt);
+            }
+            else if (auto ptr = dynamic_cast<UnaryOperation*>(node))
+            {
+                Visit(ptr->argument_);
+                FoldOrSimplify(stmt);
+            }
+            else if (auto ptr = dynamic_cast<BinaryOperation*>(node))
+            {
+                Visit(ptr->lhs_);
+                Visit(ptr->rhs_);
+                FoldOrSimplify(stmt);
+            }
+        }
+
+        // Оптимизирует stmt и возвращает число определений классов в нём. Создание экземпляров
+        // ссылается на класс, которым владеет узел ClassDefinition, поэтому ветку с определением
+        // класса нельзя удалять, даже если она не выполняется
+        size_t CountDefinitions(unique_ptr<Statement>& stmt) {
+            const size_t before = definition_count_;
+            Visit(stmt);
+            return definition_count_ - before;
+        }
+
+        void VisitAll(vector<unique_ptr<Statement>>& statements) {
+            for (auto& stmt : statements)
+            {
+                Visit(stmt);
+            }
+        }
+
+        // Оптимизирует выражение, от которого требуется только истинность (условие if,
+        // аргументы and, or и not). В таком контексте not not x равносильно x
+        void VisitCondition(unique_ptr<Statement>& stmt) {
+            Visit(stmt);
+            while (auto outer = dynamic_cast<Not*>(stmt.get()))
+            {
+                auto inner = dynamic_cast<Not*>(outer->argument_.get());
+                if (inner == nullptr)
+                {
+                    break;
+                }
+                stmt = std::move(inner->argument_);
+            }
+        }
+
+        void FoldOrSimplify(unique_ptr<Statement>& stmt) {
+            if (!TryFold(stmt))
+            {
+                Simplify(stmt);
+            }
+        }
+
+        // Вычисляет операцию над константами на этапе разбора.
+        // Если при вычислении возникает ошибка, операция остаётся как есть,
+        // чтобы ошибка была выброшена во время исполнения программы
+        bool TryFold(unique_ptr<Statement>& stmt) {
+            if (!IsFoldable(stmt.get()) || !HasConstantOperands(stmt.get()))
+            {
+                return false;
+            }
+            try
+            {
+                runtime::Closure closure;
+                runtime::DummyContext context;
+                auto folded = MakeConstant(stmt->Execute(closure, context));
+                if (!folded)
+                {
+                    return false;
+                }
+                Replace(stmt, std::move(folded));
+                return true;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+
+        static bool HasConstantOperands(Statement* stmt) {
+            if (auto ptr = dynamic_cast<UnaryOperation*>(stmt))
+            {
+                return IsConstant(ptr->argument_.get());
+            }
+            // or не вычисляет rhs, если lhs истинен, а and - если lhs ложен
+            bool is_or = dynamic_cast<Or*>(stmt) != nullptr;
+            if (is_or || dynamic_cast<And*>(stmt) != nullptr)
+            {
+                auto& operation = static_cast<BinaryOperation&>(*stmt);
+                if (IsConstant(operation.lhs_.get()))
+                {
+                    runtime::Closure closure;
+                    runtime::DummyContext context;
+                    if (runtime::IsTrue(operation.lhs_->Execute(closure, context)) == is_or)
+                    {
+                        return true;
+                    }
+                }
+            }
+            if (auto ptr = dynamic_cast<BinaryOperation*>(stmt))
+            {
+                return IsConstant(ptr->lhs_.get()) && IsConstant(ptr->rhs_.get());
+            }
+            return false;
+        }
+
+        // Алгебраические упрощения, не меняющие результат выражения
+        void Simplify(unique_ptr<Statement>& stmt) {
+            Statement* node = stmt.get();
+
+            if (auto ptr = dynamic_cast<Mult*>(node))
+            {
+                if (IsNumericConst(ptr->rhs_.get(), -1))
+                {
+                    // x * -1 -> -x
+                    Replace(stmt, make_unique<Negate>(std::move(ptr->lhs_)));
+                    Simplify(stmt);
+                }
+                else if (IsNumericConst(ptr->rhs_.get(), 1) && IsNumeric(ptr->lhs_.get()))
+                {
+                    stmt = std::move(ptr->lhs_);
+                }
+                else if (IsNumericConst(ptr->lhs_.get(), 1) && IsNumeric(ptr->rhs_.get()))
+                {
+                    stmt = std::move(ptr->rhs_);
+                }
+            }
+            else if (auto ptr = dynamic_cast<Div*>(node))
+            {
+                if (IsNumericConst(ptr->rhs_.get(), 1) && IsNumeric(ptr->lhs_.get()))
+                {
+                    stmt = std::move(ptr->lhs_);
+                }
+            }
+            else if (auto ptr = dynamic_cast<Add*>(node))
+            {
+                if (IsNumericConst(ptr->rhs_.get(), 0) && IsNumeric(ptr->lhs_.get()))
+                {
+                    stmt = std::move(ptr->lhs_);
+                }
+                else if (IsNumericConst(ptr->lhs_.get(), 0) && IsNumeric(ptr->rhs_.get()))
+                {
+                    stmt = std::move(ptr->rhs_);
+                }
+            }
+            else if (auto ptr = dynamic_cast<Sub*>(node))
+            {
+                if (IsNumericConst(ptr->rhs_.get(), 0) && IsNumeric(ptr->lhs_.get()))
+                {
+                    stmt = std::move(ptr->lhs_);
+                }
+            }
+            else if (auto ptr = dynamic_cast<Negate*>(node))
+            {
+                // --x -> x
+                auto inner = dynamic_cast<Negate*>(ptr->argument_.get());
+                if (inner != nullptr && IsNumeric(inner->argument_.get()))
+                {
+                    stmt = std::move(inner->argument_);
+                }
+            }
+            else if (auto ptr = dynamic_cast<Not*>(node))
+            {
+                // not not x -> x, если x и так имеет тип Bool
+                auto inner = dynamic_cast<Not*>(ptr->argument_.get());
+                if (inner != nullptr && IsBoolean(inner->argument_.get()))
+                {
+                    stmt = std::move(inner->argument_);
+                }
+            }
+        }
+
+        // Цикл с константно ложным условием не выполняется ни разу
+        void SimplifyWhile(unique_ptr<Statement>& stmt, While& loop) {
+            if (!IsConstant(loop.condition_.get()))
+            {
+                return;
+            }
+            runtime::Closure closure;
+            runtime::DummyContext context;
+            if (!runtime::IsTrue(loop.condition_->Execute(closure, context)))
+            {
+                Replace(stmt, make_unique<Compound>());
+            }
+        }
+
+        // if с константным условием заменяется одной из своих веток, если отбрасываемая ветка
+        // не содержит определений классов
+        void SimplifyIfElse(unique_ptr<Statement>& stmt, IfElse& if_else, bool if_defines, bool else_defines) {
+            if (!IsConstant(if_else.condition_.get()))
+            {
+                return;
+            }
+            runtime::Closure closure;
+            runtime::DummyContext context;
+            const bool condition = runtime::IsTrue(if_else.condition_->Execute(closure, context));
+            if (condition ? else_defines : if_defines)
+            {
+                return;
+            }
+            if (condition)
+            {
+                stmt = std::move(if_else.if_body_);
+            }
+            else if (if_else.else_body_)
+            {
+                stmt = std::move(if_else.else_body_);
+            }
+            else
+            {
+                Replace(stmt, make_unique<Compound>());
+            }
+        }
+
+        parse::SourceMap* source_map_;
+        // Число определений классов, пройденных при обходе
+        size_t definition_count_ = 0;
+    };
+
+    unique_ptr<Statement> Optimize(unique_ptr<Statement> stmt, parse::SourceMap* source_map) {
+        return Optimizer{source_map}.Run(std::move(stmt));
+    }
+
+}  // namespace ast
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "statement.h"
+
+namespace parse {
+    class SourceMap;
+}  // namespace parse
+
+namespace ast {
+
+    /*
+    Оптимизирующий проход по синтаксическому дереву, выполняемый после разбора программы:
+     - сворачивает константные подвыражения из NumericConst, StringConst, BoolConst и None,
+       например 2*5+10/2 превращается в NumericConst(15), а 'a' + 'b' - в StringConst("ab");
+     - заменяет унарный минус (разбирается как x * -1) узлом Negate;
+     - упрощает not not x, x * 1, 1 * x, x / 1, x + 0, x - 0, if и while с константным условием.
+       Невыполняемые ветки с определениями классов сохраняются: классами владеют узлы
+       ClassDefinition, а создание экземпляров ссылается на них.
+    Упрощение выполняется, только если оно не меняет ни вывод программы, ни выбрасываемые ею ошибки.
+    Возвращает корень оптимизированного дерева, исходное дерево при этом поглощается.
+    Если передана карта исходного текста, новые узлы получают участки заменённых ими узлов
+    */
+    std::unique_ptr<Statement> Optimize(std::unique_ptr<Statement> stmt, parse::SourceMap* source_map = nullptr);
+
+}  // namespace ast
@@ -0,0 +1,172 @@
+#include "lexer.h"
+#include "optimizer.h"
+#include "parse.h"
+#include "test_runner.h"
+
+using namespace std;
+
+namespace ast {
+
+using runtime::Closure;
+using runtime::ObjectHolder;
+
+namespace {
+
+string RunProgram(const string& program, bool optimize) {
+    istringstream is(program);
+    parse::Lexer lexer(is);
+    ParseOptions options;
+    options.optimize = optimize;
+    auto tree = ParseProgram(lexer, options);
+
+    runtime::DummyContext context;
+    Closure closure;
+    tree->Execute(closure, context);
+    return context.output.str();
+}
+
+void AssertSameOutput(const string& program) {
+    ASSERT_EQUAL(RunProgram(program, true), RunProgram(program, false));
+}
+
+void TestFoldsArithmetic() {
+    auto tree = Optimize(make_unique<Add>(
+        make_unique<Mult>(make_unique<NumericConst>(2), make_unique<NumericConst>(5)),
+        make_unique<Div>(make_unique<NumericConst>(10), make_unique<NumericConst>(2))));
+
+    auto num_ptr = dynamic_cast<NumericConst*>(tree.get());
+    ASSERT(num_ptr != nullptr);
+    ASSERT_EQUAL(num_ptr->GetValue().GetValue(), 15);
+}
+
+void TestFoldsStrings() {
+    auto tree = Optimize(make_unique<Add>(make_unique<StringConst>("a"s),
+                                          make_unique<Stringify>(make_unique<NumericConst>(1))));
+
+    auto str_ptr = dynamic_cast<StringConst*>(tree.get());
+    ASSERT(str_ptr != nullptr);
+    ASSERT_EQUAL(str_ptr->GetValue().GetValue(), "a1"s);
+}
+
+void TestFoldsLogic() {
+    auto tree = Optimize(make_unique<Or>(
+        make_unique<BoolConst>(true),
+        make_unique<Comparison>(runtime::Less, make_unique<VariableValue>("x"s),
+                                make_unique<NumericConst>(1))));
+
+    auto bool_ptr = dynamic_cast<BoolConst*>(tree.get());
+    ASSERT(bool_ptr != nullptr);
+    ASSERT_EQUAL(bool_ptr->GetValue().GetValue(), true);
+}
+
+void TestErrorsAreNotFolded() {
+    auto tree = Optimize(make_unique<Div>(make_unique<NumericConst>(1), make_unique<NumericConst>(0)));
+    ASSERT(dynamic_cast<Div*>(tree.get()) != nullptr);
+
+    Closure closure;
+    runtime::DummyContext context;
+    ASSERT_THROWS(tree->Execute(closure, context), std::runtime_error);
+}
+
+void TestUnaryMinusBecomesNegate() {
+    auto tree = Optimize(
+        make_unique<Mult>(make_unique<VariableValue>("x"s), make_unique<NumericConst>(-1)));
+    ASSERT(dynamic_cast<Negate*>(tree.get()) != nullptr);
+
+    Closure closure = {{"x"s, ObjectHolder::Own(runtime::Number(5))}};
+    runtime::DummyContext context;
+    ASSERT_EQUAL(tree->Execute(closure, context).TryAs<runtime::Number>()->GetValue(), -5);
+}
+
+void TestMultByOneKeepsTypeErrors() {
+    auto numeric = Optimize(make_unique<Mult>(
+        make_unique<Sub>(make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s)),
+        make_unique<NumericConst>(1)));
+    ASSERT(dynamic_cast<Sub*>(numeric.get()) != nullptr);
+
+    // x может оказаться строкой, поэтому x * 1 нельзя заменить на x
+    auto unknown = Optimize(
+        make_unique<Mult>(make_unique<VariableValue>("x"s), make_unique<NumericConst>(1)));
+    ASSERT(dynamic_cast<Mult*>(unknown.get()) != nullptr);
+}
+
+void TestOptimizedProgramsProduceIdenticalOutput() {
+    AssertSameOutput("print 1+2+3+4+5, 1*2*3*4*5, 1-2-3-4-5, 36/4/3, 2*5+10/2, -3, --3, -(2*4)\n"s);
+    AssertSameOutput("print 'a' + 'b', str(1 + 2) + '!', str(None), str(True)\n"s);
+    AssertSameOutput(R"(
+x = 7
+y = 'str'
+print -x, x * 1, 1 * x, x / 1, x + 0, 0 + x, x - 0, -x * -1
+print not not x, not not y, not not 0, not not None, not not (x > 3)
+print 1 < 2, 2 <= 1, 'a' == 'a', 'a' != 'b', True > False, None == None
+print True or x, False or x, True and x, 0 and x, not 1, not ''
+if not not x:
+  print 'x is true'
+if 1 > 2:
+  print 'unreachable'
+else:
+  print 'else branch'
+if 0:
+  print 'unreachable'
+print 'done'
+)"s);
+    AssertSameOutput(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add(step):
+    self.value = self.value + step * 1 - 0
+    return -self.value
+
+  def __str__():
+    return 'Counter(' + str(self.value) + ')'
+
+c = Counter()
+print c.add(2 + 3), c.add(-1), c
+if not not c.value:
+  print c.value * -1
+)"s);
+}
+
+void TestDeadBranchesKeepDefinitions() {
+    const string program = R"(
+if False:
+  class A:
+    def f():
+      return 1
+else:
+  print 'else'
+while False:
+  class B:
+    def f():
+      return 2
+if True:
+  print 'then'
+else:
+  class C:
+    def f():
+      return 3
+a = A()
+b = B()
+c = C()
+print a.f(), b.f(), c.f()
+)"s;
+    ASSERT_EQUAL(RunProgram(program, true), "else\nthen\n1 2 3\n"s);
+    AssertSameOutput(program);
+}
+
+}  // namespace
+
+void RunOptimizerTests(TestRunner& tr) {
+    RUN_TEST(tr, ast::TestFoldsArithmetic);
+    RUN_TEST(tr, ast::TestFoldsStrings);
+    RUN_TEST(tr, ast::TestFoldsLogic);
+    RUN_TEST(tr, ast::TestErrorsAreNotFolded);
+    RUN_TEST(tr, ast::TestUnaryMinusBecomesNegate);
+    RUN_TEST(tr, ast::TestMultByOneKeepsTypeErrors);
+    RUN_TEST(tr, ast::TestOptimizedProgramsProduceIdenticalOutput);
+    RUN_TEST(tr, ast::TestDeadBranchesKeepDefinitions);
+}
+
+}  // namespace ast
@@ -1,8 +1,12 @@
 #include "parse.h"
 
 #include "lexer.h"
+#include "optimizer.h"
+#include "source_map.h"
 #include "statement.h"
 
+#include <utility>
+
 using namespace std;
 
 namespace TokenType = parse::token_type;
@@ -19,22 +23,81 @@ bool operator!=(const parse::Token& token, char c) {
 
 class Parser {
 public:
-    explicit Parser(parse::Lexer& lexer)
-        : lexer_(lexer) {
+    Parser(parse::Lexer& lexer, const ParseOptions& options)
+        : lexer_(lexer)
+        , options_(options) {
+        // Реестры перебираются от дополняющего к дополняемому, и определения дополняемого
+        // реестра заменяют совпадающие по имени (см. runtime::Builtins)
+        for (const runtime::Builtins* builtins = options_.builtins; builtins != nullptr;
+             builtins = builtins->GetParent()) {
+            for (const auto& cls : builtins->GetClasses()) {
+                declared_classes_[cls->GetName()] = runtime::ObjectHolder::Share(*cls);
+            }
+            for (const auto& function : builtins->GetFunctions()) {
+                FunctionSlot& slot = functions_[function->name];
+                slot.function = function.get();
+                slot.defined = true;
+            }
+        }
     }
 
     // Program -> eps
     //          | Statement \n Program
+    //          | FunctionDefinition Program
     unique_ptr<ast::Statement> ParseProgram() {
+        const auto begin = lexer_.CurrentPosition();
         auto result = make_unique<ast::Compound>();
         while (!lexer_.CurrentToken().Is<TokenType::Eof>()) {
-            result->AddStatement(ParseStatement());
+            const auto statement_begin = lexer_.CurrentPosition();
+            if (lexer_.CurrentToken().Is<TokenType::Def>()) {
+                result->AddStatement(Counted(statement_begin, ParseFunctionDefinition()));
+            } else {
+                result->AddStatement(Counted(statement_begin, ParseStatement()));
+            }
         }
+        CheckFunctionCalls();
 
-        return result;
+        return OptimizeIfEnabled(Located(begin, std::move(result)));
     }
 
 private:
+    // Ошибка разбора с позицией текущей лексемы
+    ParseError Error(const string& message) const {
+        return Error(message, lexer_.CurrentPosition());
+    }
+    static ParseError Error(const string& message, const parse::SourcePosition& position) {
+        return ParseError(parse::DescribePosition(position) + ": "s + message);
+    }
+
+    // Записывает в карту исходного текста, что узел node занимает текст от begin
+    // до конца последней прочитанной лексемы
+    template <typename Node>
+    unique_ptr<Node> Located(const parse::SourcePosition& begin, unique_ptr<Node> node) {
+        if (options_.source_map != nullptr) {
+            options_.source_map->Set(node.get(), {begin, lexer_.PreviousTokenEnd()});
+        }
+        return node;
+    }
+
+    // Если включён подсчёт выполнения строк, оборачивает инструкцию, начинающуюся в begin,
+    // узлом, который отмечает её выполнение в счётчике строки
+    unique_ptr<ast::Statement> Counted(const parse::SourcePosition& begin, unique_ptr<ast::Statement> stmt) {
+        if (options_.line_counters == nullptr) {
+            return stmt;
+        }
+        return Located(begin, make_unique<ast::CountedStatement>(std::move(stmt),
+                                                                 options_.line_counters->GetLine(begin.line)));
+    }
+
+    // Тела методов оптимизируются сразу после разбора, так как после создания класса
+    // они становятся недоступны для изменения
+    unique_ptr<ast::Statement> OptimizeIfEnabled(unique_ptr<ast::Statement> stmt) {
+        if (!options_.optimize) {
+            return stmt;
+        }
+        return ast::Optimize(std::move(stmt), options_.source_map);
+    }
+
     // Suite -> NEWLINE INDENT (Statement)+ DEDENT
     unique_ptr<ast::Statement> ParseSuite()  // NOLINT
     {
@@ -43,50 +106,174 @@ private:
 
         lexer_.NextToken();
 
+        const auto begin = lexer_.CurrentPosition();
         auto result = make_unique<ast::Compound>();
         while (!lexer_.CurrentToken().Is<TokenType::Dedent>()) {
-            result->AddStatement(ParseStatement());  // NOLINT
+            const auto statement_begin = lexer_.CurrentPosition();
+            result->AddStatement(Counted(statement_begin, ParseStatement()));  // NOLINT
         }
+        auto located = Located(begin, std::move(result));
 
         lexer_.Expect<TokenType::Dedent>();
         lexer_.NextToken();
 
+        return located;
+    }
+
+    // Params -> '(' [Id [',' Id]*] ')'
+    vector<string> ParseParams() {
+        vector<string> result;
+        lexer_.Expect<TokenType::Char>('(');
+
+        if (lexer_.NextToken().Is<TokenType::Id>()) {
+            result.push_back(lexer_.Expect<TokenType::Id>().value);
+            while (lexer_.NextToken() == ',') {
+                result.push_back(lexer_.ExpectNext<TokenType::Id>().value);
+            }
+        }
+
+        lexer_.Expect<TokenType::Char>(')');
+        lexer_.NextToken();
         return result;
     }
 
-    // Methods -> [def id(Params) : Suite]*
+    // Methods -> [def id Params : Suite]*
     vector<runtime::Method> ParseMethods()  // NOLINT
     {
         vector<runtime::Method> result;
 
         while (lexer_.CurrentToken().Is<TokenType::Def>()) {
+            const auto begin = lexer_.CurrentPosition();
             runtime::Method m;
 
             m.name = lexer_.ExpectNext<TokenType::Id>().value;
-            lexer_.ExpectNext<TokenType::Char>('(');
-
-            if (lexer_.NextToken().Is<TokenType::Id>()) {
-                m.formal_params.push_back(lexer_.Expect<TokenType::Id>().value);
-                while (lexer_.NextToken() == ',') {
-                    m.formal_params.push_back(lexer_.ExpectNext<TokenType::Id>().value);
-                }
-            }
+            lexer_.NextToken();
+            m.formal_params = ParseParams();
 
-            lexer_.Expect<TokenType::Char>(')');
-            lexer_.ExpectNext<TokenType::Char>(':');
+            lexer_.Expect<TokenType::Char>(':');
             lexer_.NextToken();
 
-            m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            // break и continue в теле метода не относятся к циклам вне метода
+            const int outer_loop_depth = std::exchange(loop_depth_, 0);
+            in_method_ = true;
+            m.body = OptimizeIfEnabled(Located(begin, std::make_unique<ast::MethodBody>(ParseSuite())));  // NOLINT
+            in_method_ = false;
+            loop_depth_ = outer_loop_depth;
 
             result.push_back(std::move(m));
         }
         return result;
     }
 
+    // FunctionDefinition -> def Id Params : Suite
+    unique_ptr<ast::Statement> ParseFunctionDefinition()  // NOLINT
+    {
+        const auto begin = lexer_.CurrentPosition();
+        string name = lexer_.ExpectNext<TokenType::Id>().value;
+        if (name == "str"sv || name == "len"sv || declared_classes_.count(name) > 0) {
+            throw Error("Name "s + name + " is already defined"s);
+        }
+        FunctionSlot& slot = GetFunctionSlot(name);
+        if (slot.defined) {
+            throw Error("Function "s + name + " already exists"s);
+        }
+        slot.defined = true;
+
+        lexer_.NextToken();
+        slot.function->formal_params = ParseParams();
+        lexer_.Expect<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        in_function_ = true;
+        slot.function->body = OptimizeIfEnabled(Located(begin, std::make_unique<ast::MethodBody>(ParseSuite())));
+        in_function_ = false;
+
+        return Located(begin, make_unique<ast::FunctionDefinition>(std::move(slot.owner)));
+    }
+
+    // Функция, вызов которой может встретиться раньше её определения
+    struct FunctionSlot {
+        // Владеет функцией до разбора её определения, затем функцией владеет FunctionDefinition
+        unique_ptr<runtime::Function> owner;
+        runtime::Function* function = nullptr;
+        bool defined = false;
+    };
+
+    FunctionSlot& GetFunctionSlot(const string& name) {
+        auto [it, inserted] = functions_.try_emplace(name);
+        if (inserted) {
+            it->second.owner = make_unique<runtime::Function>();
+            it->second.owner->name = name;
+            it->second.function = it->second.owner.get();
+        }
+        return it->second;
+    }
+
+    // Создаёт вызов name(args): создание экземпляра объявленного класса, встроенную функцию
+    // str или len либо вызов функции. Неизвестное имя считается функцией, определённой ниже;
+    // если вместо неё ниже объявлен класс, вызов создаёт его экземпляр (см. ParseClassDefinition)
+    unique_ptr<ast::Statement> MakeCall(const parse::SourcePosition& begin, const string& name,
+                                        vector<unique_ptr<ast::Statement>> args) {
+        if (auto it = declared_classes_.find(name); it != declared_classes_.end()) {
+            return Located(begin, make_unique<ast::NewInstance>(
+                static_cast<const runtime::Class&>(*it->second), std::move(args)));  // NOLINT
+        }
+        if (name == "str"sv) {
+            if (args.size() != 1) {
+                throw Error("Function str takes exactly one argument"s);
+            }
+            return Located(begin, make_unique<ast::Stringify>(std::move(args.front())));
+        }
+        if (name == "len"sv) {
+            if (args.size() != 1) {
+                throw Error("Function len takes exactly one argument"s);
+            }
+            return Located(begin, make_unique<ast::Len>(std::move(args.front())));
+        }
+        const runtime::Function& function = *GetFunctionSlot(name).function;
+        function_calls_.push_back({&function, args.size(), begin});
+        return Located(begin, make_unique<ast::FunctionCall>(function, std::move(args)));
+    }
+
+    // Делает ещё не определённую функцию slot конструктором класса cls: вызовы, разобранные
+    // до объявления класса, создают его экземпляр. Возвращает функцию, которой должен владеть
+    // узел определения класса
+    static unique_ptr<runtime::Function> DefineConstructor(FunctionSlot& slot, const runtime::Class& cls) {
+        vector<unique_ptr<ast::Statement>> args;
+        if (const runtime::Method* init = cls.GetMethod("__init__"s)) {
+            slot.function->formal_params = init->formal_params;
+            for (const string& param : init->formal_params) {
+                args.push_back(make_unique<ast::VariableValue>(param));
+            }
+        }
+        slot.function->body = make_unique<ast::MethodBody>(
+            make_unique<ast::Return>(make_unique<ast::NewInstance>(cls, std::move(args))));
+        slot.defined = true;
+        return std::move(slot.owner);
+    }
+
+    // Проверяет, что все вызванные функции определены и получают нужное число аргументов
+    void CheckFunctionCalls() const {
+        for (const auto& [function, arg_count, position] : function_calls_) {
+            if (!functions_.at(function->name).defined) {
+                throw Error("Unknown class or function "s + function->name, position);
+            }
+            if (function->formal_params.size() != arg_count) {
+                throw Error("Function "s + function->name + " takes "s
+                                 + to_string(function->formal_params.size()) + " arguments, "s
+                                 + to_string(arg_count) + " given"s,
+                            position);
+            }
+        }
+    }
+
     // ClassDefinition -> Id ['(' Id ')'] : new_line indent MethodList dedent
     unique_ptr<ast::Statement> ParseClassDefinition()  // NOLINT
     {
         string class_name = lexer_.Expect<TokenType::Id>().value;
+        if (auto it = functions_.find(class_name); it != functions_.end() && it->second.defined) {
+            throw Error("Name "s + class_name + " is already defined"s);
+        }
 
         lexer_.NextToken();
 
@@ -98,7 +285,7 @@ private:
 
             auto it = declared_classes_.find(name);
             if (it == declared_classes_.end()) {
-                throw ParseError("Base class "s + name + " not found for class "s + class_name);
+                throw Error("Base class "s + name + " not found for class "s + class_name);
             }
             base_class = static_cast<const runtime::Class*>(it->second.Get());  // NOLINT
         }
@@ -118,10 +305,14 @@ private:
         });
 
         if (!inserted) {
-            throw ParseError("Class "s + class_name + " already exists"s);
+            throw Error("Class "s + class_name + " already exists"s);
         }
 
-        return make_unique<ast::ClassDefinition>(it->second);
+        unique_ptr<runtime::Function> constructor;
+        if (auto slot = functions_.find(class_name); slot != functions_.end()) {
+            constructor = DefineConstructor(slot->second, static_cast<const runtime::Class&>(*it->second));  // NOLINT
+        }
+        return make_unique<ast::ClassDefinition>(it->second, std::move(constructor));
     }
 
     vector<string> ParseDottedIds() {
@@ -135,11 +326,25 @@ private:
     }
 
     //  AssgnOrCall -> DottedIds = Expr
+    //               | DottedIds Subscript+ = Expr
     //               | DottedIds '(' ExprList ')'
     unique_ptr<ast::Statement> ParseAssignmentOrCall() {
         lexer_.Expect<TokenType::Id>();
+        const auto begin = lexer_.CurrentPosition();
 
         vector<string> id_list = ParseDottedIds();
+        if (lexer_.CurrentToken() == '[') {
+            unique_ptr<ast::Statement> object = MakeVariableValue(begin, std::move(id_list));
+            unique_ptr<ast::Statement> index = ParseSubscript();
+            while (lexer_.CurrentToken() == '[') {
+                object = Located(begin, make_unique<ast::Index>(std::move(object), std::move(index)));
+                index = ParseSubscript();
+            }
+            lexer_.Expect<TokenType::Char>('=');
+            lexer_.NextToken();
+            return Located(begin, make_unique<ast::IndexAssignment>(std::move(object), std::move(index),
+                                                                    ParseTest()));
+        }
         string last_name = id_list.back();
         id_list.pop_back();
 
@@ -147,18 +352,16 @@ private:
             lexer_.NextToken();
 
             if (id_list.empty()) {
-                return make_unique<ast::Assignment>(std::move(last_name), ParseTest());
+                NoteUse(last_name);
+                return Located(begin, make_unique<ast::Assignment>(std::move(last_name), ParseTest()));
             }
-            return make_unique<ast::FieldAssignment>(ast::VariableValue{std::move(id_list)},
-                                                     std::move(last_name), ParseTest());
+            NoteUse(id_list.front());
+            return Located(begin, make_unique<ast::FieldAssignment>(ast::VariableValue{std::move(id_list)},
+                                                                    std::move(last_name), ParseTest()));
         }
         lexer_.Expect<TokenType::Char>('(');
         lexer_.NextToken();
 
-        if (id_list.empty()) {
-            throw ParseError("Mython doesn't support functions, only methods: "s + last_name);
-        }
-
         vector<unique_ptr<ast::Statement>> args;
         if (lexer_.CurrentToken() != ')') {
             args = ParseTestList();
@@ -166,22 +369,27 @@ private:
         lexer_.Expect<TokenType::Char>(')');
         lexer_.NextToken();
 
-        return make_unique<ast::MethodCall>(make_unique<ast::VariableValue>(std::move(id_list)),
-                                            std::move(last_name), std::move(args));
+        if (id_list.empty()) {
+            return MakeCall(begin, last_name, std::move(args));
+        }
+
+        return Located(begin, make_unique<ast::MethodCall>(MakeVariableValue(begin, std::move(id_list)),
+                                                           std::move(last_name), std::move(args)));
     }
 
     // Expr -> Adder ['+'/'-' Adder]*
     unique_ptr<ast::Statement> ParseExpression()  // NOLINT
     {
+        const auto begin = lexer_.CurrentPosition();
         unique_ptr<ast::Statement> result = ParseAdder();
         while (lexer_.CurrentToken() == '+' || lexer_.CurrentToken() == '-') {
             char op = lexer_.CurrentToken().As<TokenType::Char>().value;
             lexer_.NextToken();
 
             if (op == '+') {
-                result = make_unique<ast::Add>(std::move(result), ParseAdder());
+                result = Located(begin, make_unique<ast::Add>(std::move(result), ParseAdder()));
             } else {
-                result = make_unique<ast::Sub>(std::move(result), ParseAdder());
+                result = Located(begin, make_unique<ast::Sub>(std::move(result), ParseAdder()));
             }
         }
         return result;
@@ -190,31 +398,62 @@ private:
     // Adder -> Mult ['*'/'/' Mult]*
     unique_ptr<ast::Statement> ParseAdder()  // NOLINT
     {
+        const auto begin = lexer_.CurrentPosition();
         unique_ptr<ast::Statement> result = ParseMult();
         while (lexer_.CurrentToken() == '*' || lexer_.CurrentToken() == '/') {
             char op = lexer_.CurrentToken().As<TokenType::Char>().value;
             lexer_.NextToken();
 
             if (op == '*') {
-                result = make_unique<ast::Mult>(std::move(result), ParseMult());
+                result = Located(begin, make_unique<ast::Mult>(std::move(result), ParseMult()));
             } else {
-                result = make_unique<ast::Div>(std::move(result), ParseMult());
+                result = Located(begin, make_unique<ast::Div>(std::move(result), ParseMult()));
             }
         }
         return result;
     }
 
-    // Mult -> '(' Expr ')'
+    // Mult -> '-' Mult
+    //       | Atom Subscript*
+    unique_ptr<ast::Statement> ParseMult()  // NOLINT
+    {
+        const auto begin = lexer_.CurrentPosition();
+        if (lexer_.CurrentToken() == '-') {
+            lexer_.NextToken();
+            auto minus_one = Located(begin, make_unique<ast::NumericConst>(-1));
+            return Located(begin, make_unique<ast::Mult>(ParseMult(), std::move(minus_one)));
+        }
+        auto result = ParseAtom();
+        while (lexer_.CurrentToken() == '[') {
+            result = Located(begin, make_unique<ast::Index>(std::move(result), ParseSubscript()));
+        }
+        return result;
+    }
+
+    // Subscript -> '[' Expr ']'
+    unique_ptr<ast::Statement> ParseSubscript()  // NOLINT
+    {
+        lexer_.Expect<TokenType::Char>('[');
+        lexer_.NextToken();
+        auto index = ParseTest();
+        lexer_.Expect<TokenType::Char>(']');
+        lexer_.NextToken();
+        return index;
+    }
+
+    // Atom -> '(' Expr ')'
+    //       | '[' [ExprList] ']'
+    //       | '{' [Expr ':' Expr [',' Expr ':' Expr]*] '}'
     //       | NUMBER
-    //       | '-' Mult
     //       | STRING
     //       | NONE
     //       | TRUE
     //       | FALSE
     //       | DottedIds '(' ExprList ')'
     //       | DottedIds
-    unique_ptr<ast::Statement> ParseMult()  // NOLINT
+    unique_ptr<ast::Statement> ParseAtom()  // NOLINT
     {
+        const auto begin = lexer_.CurrentPosition();
         if (lexer_.CurrentToken() == '(') {
             lexer_.NextToken();
             auto result = ParseTest();
@@ -222,37 +461,59 @@ private:
             lexer_.NextToken();
             return result;
         }
-        if (lexer_.CurrentToken() == '-') {
+        if (lexer_.CurrentToken() == '[') {
+            vector<unique_ptr<ast::Statement>> elements;
+            if (lexer_.NextToken() != ']') {
+                elements = ParseTestList();
+            }
+            lexer_.Expect<TokenType::Char>(']');
             lexer_.NextToken();
-            return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
+            return Located(begin, make_unique<ast::ListLiteral>(std::move(elements)));
+        }
+        if (lexer_.CurrentToken() == '{') {
+            vector<ast::DictLiteral::Item> items;
+            lexer_.NextToken();
+            while (lexer_.CurrentToken() != '}') {
+                if (!items.empty()) {
+                    lexer_.Expect<TokenType::Char>(',');
+                    lexer_.NextToken();
+                }
+                auto key = ParseTest();
+                lexer_.Expect<TokenType::Char>(':');
+                lexer_.NextToken();
+                items.emplace_back(std::move(key), ParseTest());
+            }
+            lexer_.NextToken();
+            return Located(begin, make_unique<ast::DictLiteral>(std::move(items)));
         }
         if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
             int result = num->value;
             lexer_.NextToken();
-            return make_unique<ast::NumericConst>(result);
+            return Located(begin, make_unique<ast::NumericConst>(result));
         }
         if (const auto* str = lexer_.CurrentToken().TryAs<TokenType::String>()) {
             string result = str->value;
             lexer_.NextToken();
-            return make_unique<ast::StringConst>(std::move(result));
+            return Located(begin, make_unique<ast::StringConst>(std::move(result)));
         }
         if (lexer_.CurrentToken().Is<TokenType::True>()) {
             lexer_.NextToken();
-            return make_unique<ast::BoolConst>(runtime::Bool(true));
+            return Located(begin, make_unique<ast::BoolConst>(runtime::Bool(true)));
         }
         if (lexer_.CurrentToken().Is<TokenType::False>()) {
             lexer_.NextToken();
-            return make_unique<ast::BoolConst>(runtime::Bool(false));
+            return Located(begin, make_unique<ast::BoolConst>(runtime::Bool(false)));
         }
         if (lexer_.CurrentToken().Is<TokenType::None>()) {
             lexer_.NextToken();
-            return make_unique<ast::None>();
+            return Located(begin, make_unique<ast::None>());
         }
 
         return ParseDottedIdsInMultExpr();
     }
 
     std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
+        const auto begin = lexer_.CurrentPosition();
         vector<string> names = ParseDottedIds();
 
         if (lexer_.CurrentToken() == '(') {
@@ -268,23 +529,28 @@ private:
             names.pop_back();
 
             if (!names.empty()) {
-                return make_unique<ast::MethodCall>(
-                    make_unique<ast::VariableValue>(std::move(names)), std::move(method_name),
-                    std::move(args));
+                return Located(begin, make_unique<ast::MethodCall>(MakeVariableValue(begin, std::move(names)),
+                                                                   std::move(method_name), std::move(args)));
             }
-            if (auto it = declared_classes_.find(method_name); it != declared_classes_.end()) {
-                return make_unique<ast::NewInstance>(
-                    static_cast<const runtime::Class&>(*it->second), std::move(args));  // NOLINT
-            }
-            if (method_name == "str"sv) {
-                if (args.size() != 1) {
-                    throw ParseError("Function str takes exactly one argument"s);
-                }
-                return make_unique<ast::Stringify>(std::move(args.front()));
+            return MakeCall(begin, method_name, std::move(args));
+        }
+        return MakeVariableValue(begin, std::move(names));
+    }
+
+    // Создаёт узел чтения переменной или поля, имена которых только что прочитаны начиная с begin
+    unique_ptr<ast::VariableValue> MakeVariableValue(const parse::SourcePosition& begin, vector<string> names) {
+        NoteUse(names.front());
+        return Located(begin, make_unique<ast::VariableValue>(std::move(names)));
+    }
+
+    // Отмечает чтение или присваивание переменной name для всех объемлющих циклов for
+    // с такой переменной
+    void NoteUse(const string& name) {
+        for (auto& loop_var : for_vars_) {
+            if (loop_var.name == name) {
+                loop_var.used = true;
             }
-            throw ParseError("Unknown call to "s + method_name + "()"s);
         }
-        return make_unique<ast::VariableValue>(std::move(names));
     }
 
     vector<unique_ptr<ast::Statement>> ParseTestList()  // NOLINT
@@ -303,6 +569,7 @@ private:
     unique_ptr<ast::Statement> ParseCondition()  // NOLINT
     {
         lexer_.Expect<TokenType::If>();
+        const auto begin = lexer_.CurrentPosition();
         lexer_.NextToken();
 
         auto condition = ParseTest();
@@ -319,8 +586,75 @@ private:
             else_body = ParseSuite();
         }
 
-        return make_unique<ast::IfElse>(std::move(condition), std::move(if_body),
-                                        std::move(else_body));
+        return Located(begin, make_unique<ast::IfElse>(std::move(condition), std::move(if_body),
+                                                       std::move(else_body)));
+    }
+
+    // Loop -> while LogicalExpr: Suite
+    unique_ptr<ast::Statement> ParseWhile()  // NOLINT
+    {
+        lexer_.Expect<TokenType::While>();
+        const auto begin = lexer_.CurrentPosition();
+        lexer_.NextToken();
+
+        auto condition = ParseTest();
+
+        lexer_.Expect<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        ++loop_depth_;
+        auto body = ParseSuite();
+        --loop_depth_;
+
+        return Located(begin, make_unique<ast::While>(std::move(condition), std::move(body)));
+    }
+
+    // ForLoop -> for Id in range '(' Expr [',' Expr [',' Expr]] ')' : Suite
+    unique_ptr<ast::Statement> ParseFor()  // NOLINT
+    {
+        lexer_.Expect<TokenType::For>();
+        const auto begin = lexer_.CurrentPosition();
+        string var = lexer_.ExpectNext<TokenType::Id>().value;
+        lexer_.ExpectNext<TokenType::In>();
+        if (lexer_.NextToken() != parse::Token(TokenType::Id{"range"s})) {
+            throw Error("Mython supports only 'for ... in range(...)' loops"s);
+        }
+        lexer_.ExpectNext<TokenType::Char>('(');
+        lexer_.NextToken();
+
+        auto args = ParseTestList();
+        if (args.size() > 3) {
+            throw Error("range() takes at most 3 arguments"s);
+        }
+        lexer_.Expect<TokenType::Char>(')');
+        lexer_.ExpectNext<TokenType::Char>(':');
+        lexer_.NextToken();
+
+        unique_ptr<ast::Statement> start;
+        unique_ptr<ast::Statement> stop;
+        unique_ptr<ast::Statement> step;
+        if (args.size() == 1) {
+            start = Located(begin, make_unique<ast::NumericConst>(0));
+            stop = std::move(args[0]);
+        } else {
+            start = std::move(args[0]);
+            stop = std::move(args[1]);
+            if (args.size() == 3) {
+                step = std::move(args[2]);
+            }
+        }
+
+        // Вложенный цикл с той же переменной присваивает её внешнему циклу
+        NoteUse(var);
+        for_vars_.push_back({var, false});
+        ++loop_depth_;
+        auto body = ParseSuite();
+        --loop_depth_;
+        const bool use_var = for_vars_.back().used;
+        for_vars_.pop_back();
+
+        return Located(begin, make_unique<ast::For>(std::move(var), std::move(start), std::move(stop),
+                                                    std::move(step), std::move(body), use_var));
     }
 
     // LogicalExpr -> AndTest [OR AndTest]
@@ -329,20 +663,22 @@ private:
     //          | Comparison
     unique_ptr<ast::Statement> ParseTest()  // NOLINT
     {
+        const auto begin = lexer_.CurrentPosition();
         auto result = ParseAndTest();
         while (lexer_.CurrentToken().Is<TokenType::Or>()) {
             lexer_.NextToken();
-            result = make_unique<ast::Or>(std::move(result), ParseAndTest());
+            result = Located(begin, make_unique<ast::Or>(std::move(result), ParseAndTest()));
         }
         return result;
     }
 
     unique_ptr<ast::Statement> ParseAndTest()  // NOLINT
     {
+        const auto begin = lexer_.CurrentPosition();
         auto result = ParseNotTest();
         while (lexer_.CurrentToken().Is<TokenType::And>()) {
             lexer_.NextToken();
-            result = make_unique<ast::And>(std::move(result), ParseNotTest());
+            result = Located(begin, make_unique<ast::And>(std::move(result), ParseNotTest()));
         }
         return result;
     }
@@ -350,66 +686,79 @@ private:
     unique_ptr<ast::Statement> ParseNotTest()  // NOLINT
     {
         if (lexer_.CurrentToken().Is<TokenType::Not>()) {
+            const auto begin = lexer_.CurrentPosition();
             lexer_.NextToken();
-            return make_unique<ast::Not>(ParseNotTest());  // NOLINT
+            return Located(begin, make_unique<ast::Not>(ParseNotTest()));  // NOLINT
         }
         return ParseComparison();
     }
 
     // Comparison -> Expr [COMP_OP Expr]
+    //             | Expr in Expr
     unique_ptr<ast::Statement> ParseComparison()  // NOLINT
     {
+        const auto begin = lexer_.CurrentPosition();
         auto result = ParseExpression();
 
         const auto tok = lexer_.CurrentToken();
 
         if (tok == '<') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Less, std::move(result),
-                                                ParseExpression());
+            return ParseComparisonRhs<runtime::CompareOp::Less>(begin, std::move(result));
         }
         if (tok == '>') {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Greater, std::move(result),
-                                                ParseExpression());
+            return ParseComparisonRhs<runtime::CompareOp::Greater>(begin, std::move(result));
         }
         if (tok.Is<TokenType::Eq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::Equal, std::move(result),
-                                                ParseExpression());
+            return ParseComparisonRhs<runtime::CompareOp::Equal>(begin, std::move(result));
         }
         if (tok.Is<TokenType::NotEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
-                                                ParseExpression());
+            return ParseComparisonRhs<runtime::CompareOp::NotEqual>(begin, std::move(result));
         }
         if (tok.Is<TokenType::LessOrEq>()) {
-            lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
-                                                ParseExpression());
+            return ParseComparisonRhs<runtime::CompareOp::LessOrEqual>(begin, std::move(result));
         }
         if (tok.Is<TokenType::GreaterOrEq>()) {
+            return ParseComparisonRhs<runtime::CompareOp::GreaterOrEqual>(begin, std::move(result));
+        }
+        if (tok.Is<TokenType::In>()) {
             lexer_.NextToken();
-            return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
-                                                ParseExpression());
+            return Located(begin, make_unique<ast::Contains>(std::move(result), ParseExpression()));
         }
         return result;
     }
 
+    template <runtime::CompareOp Op>
+    unique_ptr<ast::Statement> ParseComparisonRhs(const parse::SourcePosition& begin, unique_ptr<ast::Statement> lhs) {
+        lexer_.NextToken();
+        return Located(begin, make_unique<ast::CompareOperation<Op>>(std::move(lhs), ParseExpression()));
+    }
+
     // Statement -> SimpleStatement Newline
     //           | class ClassDefinition
     //           | if Condition
+    //           | while Loop
+    //           | for ForLoop
     unique_ptr<ast::Statement> ParseStatement()  // NOLINT
     {
         const auto& tok = lexer_.CurrentToken();
 
         if (tok.Is<TokenType::Class>()) {
+            const auto begin = lexer_.CurrentPosition();
             lexer_.NextToken();
-            return ParseClassDefinition();  // NOLINT
+            return Located(begin, ParseClassDefinition());  // NOLINT
         }
         if (tok.Is<TokenType::If>()) {
             return ParseCondition();
         }
+        if (tok.Is<TokenType::While>()) {
+            return ParseWhile();
+        }
+        if (tok.Is<TokenType::For>()) {
+            return ParseFor();
+        }
+        if (tok.Is<TokenType::Def>()) {
+            throw Error("Functions can be defined only at the top level of a program"s);
+        }
         auto result = ParseSimpleStatement();
         lexer_.Expect<TokenType::Newline>();
         lexer_.NextToken();
@@ -418,13 +767,29 @@ private:
 
     // StatementBody -> return Expression
     //               | print ExpressionList
+    //               | break
+    //               | continue
     //               | AssignmentOrCall
     unique_ptr<ast::Statement> ParseSimpleStatement() {
         const auto& tok = lexer_.CurrentToken();
+        const auto begin = lexer_.CurrentPosition();
 
         if (tok.Is<TokenType::Return>()) {
             lexer_.NextToken();
-            return make_unique<ast::Return>(ParseTest());
+            auto result = ParseTest();
+            // return object.method(...) и return function(...) внутри метода или функции -
+            // хвостовые вызовы
+            if (in_method_ || in_function_) {
+                if (dynamic_cast<ast::MethodCall*>(result.get()) != nullptr) {
+                    return Located(begin, make_unique<ast::TailReturn>(unique_ptr<ast::MethodCall>(
+                                              static_cast<ast::MethodCall*>(result.release()))));
+                }
+                if (dynamic_cast<ast::FunctionCall*>(result.get()) != nullptr) {
+                    return Located(begin, make_unique<ast::TailReturn>(unique_ptr<ast::FunctionCall>(
+                                              static_cast<ast::FunctionCall*>(result.release()))));
+                }
+            }
+            return Located(begin, make_unique<ast::Return>(std::move(result)));
         }
         if (tok.Is<TokenType::Print>()) {
             lexer_.NextToken();
@@ -432,17 +797,47 @@ private:
             if (!lexer_.CurrentToken().Is<TokenType::Newline>()) {
                 args = ParseTestList();
             }
-            return make_unique<ast::Print>(std::move(args));
+            return Located(begin, make_unique<ast::Print>(std::move(args)));
+        }
+        if (tok.Is<TokenType::Break>() || tok.Is<TokenType::Continue>()) {
+            if (loop_depth_ == 0) {
+                throw Error("'break' and 'continue' are allowed only inside a loop"s);
+            }
+            const bool is_break = tok.Is<TokenType::Break>();
+            lexer_.NextToken();
+            if (is_break) {
+                return Located(begin, make_unique<ast::Break>());
+            }
+            return Located(begin, make_unique<ast::Continue>());
         }
         return ParseAssignmentOrCall();
     }
 
     parse::Lexer& lexer_;
+    const ParseOptions& options_;
     runtime::Closure declared_classes_;
+    bool in_method_ = false;
+    bool in_function_ = false;
+    int loop_depth_ = 0;
+    unordered_map<string, FunctionSlot> functions_;
+    // Вызовы функций с числом переданных аргументов, проверяются после разбора программы
+    struct FunctionCallInfo {
+        const runtime::Function* function = nullptr;
+        size_t arg_count = 0;
+        parse::SourcePosition position;
+    };
+    vector<FunctionCallInfo> function_calls_;
+
+    struct ForVariable {
+        string name;
+        bool used = false;
+    };
+    // Переменные разбираемых в данный момент циклов for, от внешнего к внутреннему
+    vector<ForVariable> for_vars_;
 };
 
 }  // namespace
 
-unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
-    return Parser{lexer}.ParseProgram();
+unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer, const ParseOptions& options) {
+    return Parser{lexer, options}.ParseProgram();
 }
\ No newline at end of file
@@ -5,14 +5,37 @@
 
 namespace parse {
 class Lexer;
-}
+class SourceMap;
+}  // namespace parse
+
+namespace ast {
+class LineCounters;
+}  // namespace ast
 
 namespace runtime {
 class Executable;
-}
+class Builtins;
+}  // namespace runtime
 
 struct ParseError : std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
-std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
\ No newline at end of file
+// Параметры разбора программы
+struct ParseOptions {
+    // Выполнять после разбора оптимизирующий проход (см. optimizer.h)
+    bool optimize = true;
+    // Функции и классы встраивающего приложения, доступные программе (может быть nullptr)
+    const runtime::Builtins* builtins = nullptr;
+    // Карта, в которую записываются участки исходного текста всех узлов дерева (может быть nullptr)
+    parse::SourceMap* source_map = nullptr;
+    // Счётчики выполнения строк программы (см. line_counters.h). Если nullptr, подсчёт выключен
+    ast::LineCounters* line_counters = nullptr;
+};
+
+// Разбирает программу. Сообщения ParseError и LexerError начинаются с позиции ошибки в тексте.
+// Выполнение программы не меняет её дерево, поэтому одно дерево можно
+// выполнять многократно и одновременно из нескольких потоков, каждый раз с собственными
+// Closure и Context
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer,
+                                                  const ParseOptions& options = {});
\ No newline at end of file
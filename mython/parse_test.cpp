@@ -1,8 +1,11 @@
 #include "lexer.h"
 #include "parse.h"
+#include "source_map.h"
 #include "statement.h"
 #include "test_runner.h"
 
+#include <thread>
+
 using namespace std;
 
 namespace parse {
@@ -173,6 +176,613 @@ print x.call_count
     ASSERT_EQUAL(context.output.str(), "17\n1\n115\n"s);
 }
 
+void TestTailRecursion() {
+    const string program = R"(
+class Counter:
+  def count(n, acc):
+    if n == 0:
+      return acc
+    return self.count(n - 1, acc + 1)
+
+  def is_even(n):
+    if n == 0:
+      return True
+    return self.is_odd(n - 1)
+
+  def is_odd(n):
+    if n == 0:
+      return False
+    return self.is_even(n - 1)
+
+c = Counter()
+print c.count(100000, 0)
+print c.is_even(100001)
+)"s;
+
+    runtime::DummyContext context;
+    context.SetMaxCallDepth(100);
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "100000\nFalse\n"s);
+}
+
+void TestRecursionLimit() {
+    const string program = R"(
+class Summator:
+  def sum(n):
+    if n == 0:
+      return 0
+    return n + self.sum(n - 1)
+
+s = Summator()
+print s.sum(99)
+print s.sum(100)
+)"s;
+
+    runtime::DummyContext context;
+    context.SetMaxCallDepth(100);
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    ASSERT_THROWS(tree->Execute(closure, context), runtime::RecursionError);
+    ASSERT_EQUAL(context.output.str(), "4950\n"s);
+}
+
+void TestRecursionLimitWithDeepExpressions() {
+    // Каждый уровень рекурсии вычисляет 30 вложенных сложений, поэтому стек основного потока
+    // кончается раньше, чем достигается глубина по умолчанию. Это должна быть ошибка RecursionError,
+    // а не аварийное завершение процесса
+    string expression = "self.f(n - 1)"s;
+    for (int i = 0; i < 30; ++i) {
+        expression = "(1 + "s + expression + ")"s;
+    }
+    const string program = R"(
+class Deep:
+  def f(n):
+    if n == 0:
+      return 0
+    return )"s + expression + R"(
+
+d = Deep()
+print d.f(10)
+print d.f()"s + to_string(runtime::Context::DEFAULT_MAX_CALL_DEPTH) + R"()
+)"s;
+
+    runtime::DummyContext context;
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    ASSERT_THROWS(tree->Execute(closure, context), runtime::RecursionError);
+    ASSERT_EQUAL(context.output.str(), "300\n"s);
+
+    // После ошибки глубина вызовов восстановлена, и контекст пригоден для работы
+    context.output.str({});
+    auto again = ParseProgramFromString("print d.f(20)\n"s);
+    again->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "600\n"s);
+}
+
+void TestWhileLoop() {
+    const string program = R"(
+i = 0
+total = 0
+while i < 10:
+  i = i + 1
+  if i == 3:
+    continue
+  if i > 7:
+    break
+  total = total + i
+print i, total
+
+class Grid:
+  def cells(rows, cols):
+    count = 0
+    r = 0
+    while r < rows:
+      c = 0
+      while True:
+        if c == cols:
+          break
+        count = count + 1
+        c = c + 1
+      r = r + 1
+    return count
+
+g = Grid()
+print g.cells(3, 4)
+while False:
+  print 'unreachable'
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "8 25\n12\n"s);
+}
+
+void TestBreakOutsideLoop() {
+    ASSERT_THROWS(ParseProgramFromString("break\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString(R"(
+while True:
+  class A:
+    def f():
+      continue
+)"s),
+                  ParseError);
+}
+
+void TestForRangeLoop() {
+    const string program = R"(
+total = 0
+for i in range(10):
+  if i == 3:
+    continue
+  if i > 7:
+    break
+  total = total + i
+print i, total
+for j in range(10, 0, -3):
+  print j
+print j
+count = 0
+for k in range(2, 5):
+  count = count + 1
+print k, count
+for m in range(5, 5):
+  print 'unreachable'
+n = 0
+for a in range(3):
+  for b in range(a):
+    n = n + 1
+print n
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "8 25\n10\n7\n4\n1\n1\n4 3\n3\n"s);
+    ASSERT(closure.count("m"s) == 0);
+}
+
+void TestForLoopVariableAfterLoop() {
+    // Значение переменной после цикла не зависит от того, читает ли её тело цикла
+    const string program = R"(
+for i in range(0, 10):
+  if total == 2:
+    break
+  total = total + 1
+print i
+for j in range(3):
+  j = 100
+print j
+for k in range(10, 0, -2):
+  break
+print k
+for a in range(3):
+  for a in range(5, 7):
+    x = 0
+print a
+)"s;
+
+    for (const bool optimize : {false, true}) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        closure["total"s] = runtime::ObjectHolder::Own(runtime::Number{0});
+        ParseOptions options;
+        options.optimize = optimize;
+        istringstream input(program);
+        Lexer lexer(input);
+        auto tree = ParseProgram(lexer, options);
+        tree->Execute(closure, context);
+        ASSERT_EQUAL(context.output.str(), "2\n100\n10\n6\n"s);
+    }
+}
+
+void TestForRangeErrors() {
+    ASSERT_THROWS(ParseProgramFromString("for i in items:\n  print i\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString("for i in range(1, 2, 3, 4):\n  print i\n"s),
+                  ParseError);
+
+    for (const string& program : {"for i in range(0, 3, 0):\n  print i\n"s,
+                                 "for i in range('abc'):\n  print i\n"s}) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        ASSERT_THROWS(tree->Execute(closure, context), std::runtime_error);
+    }
+}
+
+void TestLists() {
+    const string program = R"(
+x = [1, 'a', None, [True, 2]]
+print x, len(x), len('abc'), len([])
+x.append(5)
+print x[4], x[-1], x[3][0]
+x[3][1] = 7
+x[0] = x[0] + 10
+print x
+y = x
+y.append(6)
+print len(x), [1, 2] == [1, 2], [1] != [2], not []
+
+class Stack:
+  def __init__():
+    self.items = []
+
+  def push(value):
+    self.items.append(value)
+
+  def top():
+    return self.items[len(self.items) - 1]
+
+s = Stack()
+for i in range(5):
+  s.push(i * i)
+print s.top(), s.items
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(),
+                 "[1, 'a', None, [True, 2]] 4 3 0\n5 5 True\n[11, 'a', None, [True, 7], 5]\n"
+                 "6 True True True\n16 [0, 1, 4, 9, 16]\n"s);
+}
+
+void TestListErrors() {
+    for (const string& program : {"x = [1]\nprint x[1]\n"s, "x = [1]\nprint x['a']\n"s,
+                                  "x = 1\nprint x[0]\n"s, "x = []\nx[0] = 1\n"s,
+                                  "x = []\nx.pop()\n"s, "print len(1)\n"s}) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        ASSERT_THROWS(tree->Execute(closure, context), std::runtime_error);
+    }
+}
+
+void TestReturnContainerMethodCall() {
+    // return obj.method(...) для списков и словарей вызывает их встроенные методы,
+    // а не превращается в хвостовой вызов метода класса
+    const string program = R"(
+class Store:
+  def __init__():
+    self.d = {1: 'one', 2: 'two'}
+    self.items = []
+
+  def get(key):
+    return self.d.get(key)
+
+  def keys():
+    return self.d.keys()
+
+  def add(value):
+    return self.items.append(value)
+
+def lookup(d, key):
+  return d.get(key, 'missing')
+
+s = Store()
+print s.get(1), s.get(3), s.keys(), s.add(5), s.items
+print lookup({1: 2}, 1), lookup({}, 1)
+)"s;
+
+    for (const bool optimize : {false, true}) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        ParseOptions options;
+        options.optimize = optimize;
+        istringstream input(program);
+        Lexer lexer(input);
+        auto tree = ParseProgram(lexer, options);
+        tree->Execute(closure, context);
+        ASSERT_EQUAL(context.output.str(), "one None [1, 2] None [5]\n2 missing\n"s);
+    }
+}
+
+void TestDicts() {
+    const string program = R"(
+d = {1: 'one', 'two': 2, True: [1], None: 0}
+print d, len(d), d[1], d['two'], d[True], d[None]
+d['three'] = 3
+d[1] = 'uno'
+print d[1], len(d), 1 in d, 5 in d, 'three' in d
+print d.get(5), d.get(5, 'default'), d.get('two'), d.keys(), d.values()
+print 2 in [1, 2], 'bc' in 'abc', {1: 2} == {1: 2}, {1: 2} != {1: 3}, not {}
+
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def __hash__():
+    return self.x * 31 + self.y
+
+  def __eq__(other):
+    return self.x == other.x and self.y == other.y
+
+names = {}
+names[Point(1, 2)] = 'a'
+names[Point(2, 1)] = 'b'
+names[Point(1, 2)] = 'c'
+print len(names), names[Point(1, 2)], Point(2, 1) in names, Point(3, 3) in names
+
+squares = {}
+for i in range(100):
+  squares[i] = i * i
+print len(squares), squares[99]
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(),
+                 "{1: 'one', 'two': 2, True: [1], None: 0} 4 one 2 [1] 0\n"
+                 "uno 5 True False True\n"
+                 "None default 2 [1, 'two', True, None, 'three'] ['uno', 2, [1], 0, 3]\n"
+                 "True True True True True\n"
+                 "2 c True False\n"
+                 "100 9801\n"s);
+}
+
+void TestDictErrors() {
+    for (const string& program : {"d = {}\nprint d[1]\n"s, "d = {}\nd[[1]] = 1\n"s,
+                                  "print 1 in 2\n"s, "d = {}\nd.pop(1)\n"s}) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        ASSERT_THROWS(tree->Execute(closure, context), std::runtime_error);
+    }
+}
+
+void TestFunctions() {
+    const string program = R"(
+def fact(n):
+  if n < 2:
+    return 1
+  return n * fact(n - 1)
+
+class Doubler:
+  def apply(n):
+    return twice(n) + 0
+
+def twice(x):
+  return x * 2
+
+d = Doubler()
+print fact(10), d.apply(21), is_even(100001), count(100000, 0)
+greet('world')
+
+def is_even(n):
+  if n == 0:
+    return True
+  return is_odd(n - 1)
+
+def is_odd(n):
+  if n == 0:
+    return False
+  return is_even(n - 1)
+
+def count(n, acc):
+  if n == 0:
+    return acc
+  return count(n - 1, acc + 1)
+
+def greet(name):
+  print 'hello', name
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "3628800 42 False 100000\nhello world\n"s);
+}
+
+void TestFunctionErrors() {
+    ASSERT_THROWS(ParseProgramFromString("print missing(1)\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString("def f(a):\n  return a\nprint f(1, 2)\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString("def f():\n  return 1\ndef f():\n  return 2\n"s),
+                  ParseError);
+    ASSERT_THROWS(ParseProgramFromString("def len(x):\n  return 1\n"s), ParseError);
+    ASSERT_THROWS(ParseProgramFromString("def A():\n  return 1\nclass A:\n  def f():\n    return 1\n"s),
+                  ParseError);
+    ASSERT_THROWS(ParseProgramFromString("if True:\n  def f():\n    return 1\n"s), ParseError);
+}
+
+void TestCallResolution() {
+    // Вызов класса и встроенных функций инструкцией, а не выражением
+    const string statements = R"(
+class Greeter:
+  def __init__(name):
+    print 'hello', name
+
+Greeter('world')
+str(1)
+len('abc')
+)"s;
+    // Класс, вызванный до своего объявления, как и функция, находится после разбора программы
+    const string forward = R"(
+def make(x, y):
+  return Point(x, y)
+
+class Empty:
+  def f():
+    return 0
+
+def empty():
+  return Counter()
+
+p = make(1, 2)
+c = empty()
+e = Empty()
+print p.x + p.y, c.n, e.f()
+
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+class Counter:
+  def __init__():
+    self.n = 5
+)"s;
+
+    for (const string& program : {statements, forward}) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        ParseProgramFromString(program)->Execute(closure, context);
+        ASSERT_EQUAL(context.output.str(), program == statements ? "hello world\n"s : "3 5 0\n"s);
+    }
+
+    auto parse_error = [](const string& program) {
+        try {
+            ParseProgramFromString(program);
+        } catch (const exception& e) {
+            return string(e.what());
+        }
+        return "no error"s;
+    };
+    ASSERT_EQUAL(parse_error("Missing(1)\n"s), "Line 1, column 1: Unknown class or function Missing"s);
+    ASSERT_EQUAL(parse_error("x = Late(1)\nclass Late:\n  def __init__():\n    self.x = 1\n"s),
+                 "Line 1, column 5: Function Late takes 0 arguments, 1 given"s);
+    ASSERT_THROWS(ParseProgramFromString("str(1, 2)\n"s), ParseError);
+}
+
+void TestErrorPositions() {
+    auto parse_error = [](const string& program) {
+        try {
+            ParseProgramFromString(program);
+        } catch (const exception& e) {
+            return string(e.what());
+        }
+        return "no error"s;
+    };
+
+    ASSERT_EQUAL(parse_error("x = 1\ny = (2 + \n"s), "Line 2, column 10: expected Id, found Newline"s);
+    ASSERT_EQUAL(parse_error("x = 1\nprint missing(1)\n"s), "Line 2, column 7: Unknown class or function missing"s);
+    ASSERT_EQUAL(parse_error("if x:\n  break\n"s).substr(0, 18), "Line 2, column 3: "s);
+}
+
+void TestSourceMap() {
+    const string program = "x = 1\nif x > 0:\n  print x * 2 + 3\n"s;
+    istringstream is(program);
+    Lexer lexer(is);
+    SourceMap source_map;
+    ParseOptions options;
+    options.optimize = false;
+    options.source_map = &source_map;
+    auto tree = ParseProgram(lexer, options);
+
+    const SourceSpan* span = source_map.Find(tree.get());
+    ASSERT(span != nullptr);
+    ASSERT_EQUAL(span->begin.line, 1u);
+    ASSERT_EQUAL(span->begin.column, 1u);
+    // Программа занимает весь текст, включая завершающий перевод строки
+    ASSERT_EQUAL(span->end.line, 4u);
+    ASSERT_EQUAL(span->end.column, 1u);
+    ASSERT(source_map.GetSize() > 10);
+
+    // Ошибка выполнения указывает на самую вложенную инструкцию
+    runtime::DummyContext context;
+    runtime::Closure closure{{"x"s, runtime::ObjectHolder::Own(runtime::String{"a"s})}};
+    istringstream failing_is("if x:\n  y = 1\n  y = y + x\n"s);
+    Lexer failing_lexer(failing_is);
+    auto failing = ParseProgram(failing_lexer, options);
+    try {
+        failing->Execute(closure, context);
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT_EQUAL(DescribeCurrentError(e, context, source_map).substr(0, 18), "Line 3, column 3: "s);
+    }
+}
+
+const string REUSABLE_PROGRAM = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def __str__():
+    return '(' + str(self.x) + ', ' + str(self.y) + ')'
+
+class Node:
+  def __init__(registry, value):
+    self.value = value
+    registry.append(self)
+
+def make_points(n):
+  points = []
+  for i in range(n):
+    points.append(Point(i, i * i))
+  return points
+
+points = make_points(4)
+print points[0], points[3], len(points)
+
+registry = []
+node = Node(registry, 'kept')
+node = Node(registry, 'also kept')
+node = None
+first = registry[0]
+print len(registry), first.value
+)"s;
+
+const string REUSABLE_OUTPUT = "(0, 0) (3, 9) 4\n2 kept\n"s;
+
+void TestProgramIsReusable() {
+    auto tree = ParseProgramFromString(REUSABLE_PROGRAM);
+
+    // Программа разбирается один раз и выполняется несколько раз с новыми глобальными переменными
+    for (int run = 0; run < 3; ++run) {
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        tree->Execute(closure, context);
+        ASSERT_EQUAL(context.output.str(), REUSABLE_OUTPUT);
+    }
+}
+
+void TestProgramRunsConcurrently() {
+    auto tree = ParseProgramFromString(REUSABLE_PROGRAM);
+
+    const int thread_count = 4;
+    const int runs_per_thread = 25;
+    vector<string> outputs(thread_count * runs_per_thread);
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&tree, &outputs, t, runs_per_thread] {
+            for (int run = 0; run < runs_per_thread; ++run) {
+                runtime::DummyContext context;
+                runtime::Closure closure;
+                tree->Execute(closure, context);
+                outputs[t * runs_per_thread + run] = context.output.str();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (const auto& output : outputs) {
+        ASSERT_EQUAL(output, REUSABLE_OUTPUT);
+    }
+}
+
 void TestComplexLogicalExpression() {
     const string program = R"(
 a = 1
@@ -191,6 +801,29 @@ print ok
     ASSERT_EQUAL(context.output.str(), "False\n"s);
 }
 
+void TestShortCircuitLogic() {
+    const string program = R"(
+class Guard:
+  def check(name, result):
+    print 'check', name
+    return result
+
+g = Guard()
+print 0 and g.check('and', True)
+print 1 and g.check('and', 0)
+print 1 or g.check('or', True)
+print '' or g.check('or', 'x')
+)"s;
+
+    runtime::DummyContext context;
+
+    runtime::Closure closure;
+    auto tree = ParseProgramFromString(program);
+    tree->Execute(closure, context);
+
+    ASSERT_EQUAL(context.output.str(), "False\ncheck and\nFalse\nTrue\ncheck or\nTrue\n"s);
+}
+
 void TestClassicalPolymorphism() {
     const string program = R"(
 class Shape:
@@ -253,6 +886,27 @@ void TestParseProgram(TestRunner& tr) {
     RUN_TEST(tr, parse::TestReturnFromIf);
     RUN_TEST(tr, parse::TestRecursion);
     RUN_TEST(tr, parse::TestRecursion2);
+    RUN_TEST(tr, parse::TestTailRecursion);
+    RUN_TEST(tr, parse::TestRecursionLimit);
+    RUN_TEST(tr, parse::TestRecursionLimitWithDeepExpressions);
+    RUN_TEST(tr, parse::TestWhileLoop);
+    RUN_TEST(tr, parse::TestBreakOutsideLoop);
+    RUN_TEST(tr, parse::TestForRangeLoop);
+    RUN_TEST(tr, parse::TestForLoopVariableAfterLoop);
+    RUN_TEST(tr, parse::TestForRangeErrors);
+    RUN_TEST(tr, parse::TestLists);
+    RUN_TEST(tr, parse::TestListErrors);
+    RUN_TEST(tr, parse::TestReturnContainerMethodCall);
+    RUN_TEST(tr, parse::TestDicts);
+    RUN_TEST(tr, parse::TestDictErrors);
+    RUN_TEST(tr, parse::TestFunctions);
+    RUN_TEST(tr, parse::TestFunctionErrors);
+    RUN_TEST(tr, parse::TestCallResolution);
+    RUN_TEST(tr, parse::TestErrorPositions);
+    RUN_TEST(tr, parse::TestSourceMap);
+    RUN_TEST(tr, parse::TestProgramIsReusable);
+    RUN_TEST(tr, parse::TestProgramRunsConcurrently);
     RUN_TEST(tr, parse::TestComplexLogicalExpression);
+    RUN_TEST(tr, parse::TestShortCircuitLogic);
     RUN_TEST(tr, parse::TestClassicalPolymorphism);
 }
\ No newline at end of file
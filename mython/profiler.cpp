@@ -0,0 +1,220 @@
+#include "profiler.h"
+
+#include "runtime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        // Профилировщик, запущенный в текущем потоке. Таймер посылает сигнал именно этому потоку
+        thread_local Profiler* current_profiler = nullptr;
+
+        const string MODULE_FRAME = "<module>"s;
+
+        string FrameName(const ProfileFrame& frame) {
+            if (frame.function != nullptr)
+            {
+                return frame.function->name;
+            }
+            // Кадр вызова несуществующего метода попадает в стек до того, как вызов завершится ошибкой
+            return frame.cls->GetName() + "."s + (frame.method != nullptr ? frame.method->name : "?"s);
+        }
+
+        bool IsSeparator(const ProfileFrame& frame) {
+            return frame.cls == nullptr && frame.method == nullptr && frame.function == nullptr;
+        }
+
+        // Вызывает f для каждой выборки с именами её кадров от внешнего к внутреннему
+        template <typename F>
+        void ForEachSample(const vector<ProfileFrame>& samples, size_t size, F f) {
+            vector<string> names;
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (IsSeparator(samples[i]))
+                {
+                    f(names);
+                    names.clear();
+                }
+                else
+                {
+                    names.push_back(FrameName(samples[i]));
+                }
+            }
+        }
+    }  // namespace
+
+    Profiler::Profiler(chrono::microseconds interval, size_t max_stack_depth, size_t buffer_frames)
+        : interval_(max(interval, chrono::microseconds(1))), stack_(max_stack_depth), samples_(buffer_frames) {
+    }
+
+    Profiler::~Profiler() {
+        Stop();
+    }
+
+    void Profiler::HandleSignal([[maybe_unused]] int signal) {
+        const int saved_errno = errno;
+        if (Profiler* profiler = current_profiler)
+        {
+            profiler->Sample();
+        }
+        errno = saved_errno;
+    }
+
+    void Profiler::Start() {
+        if (running_)
+        {
+            return;
+        }
+        if (current_profiler != nullptr)
+        {
+            throw runtime_error("Another profiler is already running in this thread"s);
+        }
+
+        static once_flag handler_installed;
+        call_once(handler_installed, [] {
+            struct sigaction action {};
+            action.sa_handler = &Profiler::HandleSignal;
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGPROF, &action, nullptr);
+        });
+
+        sigevent event{};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event._sigev_un._tid = gettid();
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer_) != 0)
+        {
+            throw runtime_error("Failed to create the profiler timer"s);
+        }
+
+        current_profiler = this;
+        running_ = true;
+
+        const auto seconds = chrono::duration_cast<chrono::seconds>(interval_);
+        itimerspec spec{};
+        spec.it_interval.tv_sec = static_cast<time_t>(seconds.count());
+        spec.it_interval.tv_nsec = static_cast<long>(chrono::nanoseconds(interval_ - seconds).count());
+        spec.it_value = spec.it_interval;
+        timer_settime(timer_, 0, &spec, nullptr);
+    }
+
+    void Profiler::Stop() {
+        if (!running_)
+        {
+            return;
+        }
+        timer_delete(timer_);
+        // Сигнал, пришедший после удаления таймера, обработчик пропустит
+        current_profiler = nullptr;
+        running_ = false;
+    }
+
+    void Profiler::Sample() noexcept {
+        // Прямой вызов может быть прерван сигналом; вложенная выборка пропускается
+        if (sampling_.exchange(true, memory_order_acquire))
+        {
+            dropped_count_.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        const size_t depth = min(depth_.load(memory_order_relaxed), stack_.size());
+        atomic_signal_fence(memory_order_acquire);
+        const size_t position = samples_size_.load(memory_order_relaxed);
+        if (position + depth + 1 > samples_.size())
+        {
+            dropped_count_.fetch_add(1, memory_order_relaxed);
+        }
+        else
+        {
+            copy(stack_.begin(), stack_.begin() + depth, samples_.begin() + position);
+            samples_[position + depth] = ProfileFrame{};
+            samples_size_.store(position + depth + 1, memory_order_release);
+            sample_count_.fetch_add(1, memory_order_relaxed);
+        }
+        sampling_.store(false, memory_order_release);
+    }
+
+    size_t Profiler::GetSampleCount() const {
+        return sample_count_.load(memory_order_relaxed);
+    }
+
+    size_t Profiler::GetDroppedCount() const {
+        return dropped_count_.load(memory_order_relaxed);
+    }
+
+    void Profiler::WriteFoldedStacks(ostream& out) const {
+        map<string, size_t> stacks;
+        ForEachSample(samples_, samples_size_.load(memory_order_acquire), [&stacks](const vector<string>& names) {
+            string stack = MODULE_FRAME;
+            for (const auto& name : names)
+            {
+                stack += ';';
+                stack += name;
+            }
+            ++stacks[stack];
+        });
+
+        for (const auto& [stack, count] : stacks)
+        {
+            out << stack << ' ' << count << '\n';
+        }
+    }
+
+    void Profiler::WriteReport(ostream& out) const {
+        struct Times {
+            size_t self = 0;
+            size_t total = 0;
+        };
+        map<string, Times> times;
+        ForEachSample(samples_, samples_size_.load(memory_order_acquire), [&times](const vector<string>& names) {
+            ++times[names.empty() ? MODULE_FRAME : names.back()].self;
+            // Рекурсивный вызов учитывается в полном времени один раз на выборку
+            set<string_view> seen{MODULE_FRAME};
+            ++times[MODULE_FRAME].total;
+            for (const auto& name : names)
+            {
+                if (seen.insert(name).second)
+                {
+                    ++times[name].total;
+                }
+            }
+        });
+
+        vector<pair<string, Times>> rows(times.begin(), times.end());
+        stable_sort(rows.begin(), rows.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second.self > rhs.second.self;
+        });
+
+        const size_t samples = GetSampleCount();
+        const double sample_ms = chrono::duration<double, milli>(interval_).count();
+        auto percent = [samples](size_t count) {
+            return samples == 0 ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(samples);
+        };
+
+        out << "Samples: "sv << samples << ", interval "sv << interval_.count() << " us, dropped "sv
+            << GetDroppedCount() << '\n';
+        out << setw(12) << "self, ms"sv << setw(9) << "self %"sv << setw(12) << "total, ms"sv << setw(9)
+            << "total %"sv << "  name"sv << '\n';
+        for (const auto& [name, t] : rows)
+        {
+            out << fixed << setprecision(1) << setw(12) << static_cast<double>(t.self) * sample_ms << setw(9)
+                << percent(t.self) << setw(12) << static_cast<double>(t.total) * sample_ms << setw(9)
+                << percent(t.total) << "  "sv << name << '\n';
+        }
+    }
+
+}  // namespace runtime
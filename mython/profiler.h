@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <iosfwd>
+#include <vector>
+
+namespace runtime {
+
+    class Class;
+    struct Method;
+    struct Function;
+
+    // Кадр теневого стека вызовов: метод класса (cls и method) либо функция (function)
+    struct ProfileFrame {
+        const Class* cls = nullptr;
+        const Method* method = nullptr;
+        const Function* function = nullptr;
+    };
+
+    /*
+     * Выборочный профилировщик программ Mython.
+     *
+     * Пока профилировщик подключён к контексту (Context::SetProfiler), вызовы методов и функций
+     * отмечаются в теневом стеке. После Start таймер процессорного времени потока, вызвавшего
+     * Start, раз в interval посылает этому потоку SIGPROF, и обработчик копирует теневой стек
+     * в заранее выделенный буфер. Обработчик не выделяет память и не захватывает блокировок.
+     *
+     * По собранным выборкам строятся свёрнутые стеки в формате flamegraph.pl
+     * и таблица собственного и полного времени методов. Кадры хранят указатели на классы,
+     * методы и функции, поэтому выводить их нужно, пока существует профилируемая программа
+     */
+    class Profiler {
+    public:
+        explicit Profiler(std::chrono::microseconds interval = std::chrono::milliseconds(1),
+                          size_t max_stack_depth = 1 << 14, size_t buffer_frames = 1 << 18);
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        ~Profiler();
+
+        // Запускает выборку в текущем потоке. В потоке может работать только один профилировщик.
+        // Если таймер создать не удалось, выбрасывает runtime_error
+        void Start();
+        void Stop();
+
+        // Отмечают вход в метод или функцию и выход из них
+        void Enter(const ProfileFrame& frame) noexcept {
+            const size_t depth = depth_.load(std::memory_order_relaxed);
+            if (depth < stack_.size()) {
+                stack_[depth] = frame;
+            }
+            // Кадр должен быть записан до того, как его увидит обработчик сигнала
+            std::atomic_signal_fence(std::memory_order_release);
+            depth_.store(depth + 1, std::memory_order_relaxed);
+        }
+        void Leave() noexcept {
+            depth_.store(depth_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+        // Заменяет верхний кадр при хвостовом вызове
+        void Replace(const ProfileFrame& frame) noexcept {
+            const size_t depth = depth_.load(std::memory_order_relaxed);
+            if (depth > 0 && depth <= stack_.size()) {
+                // Пока кадр перезаписывается, обработчик не должен его читать
+                depth_.store(depth - 1, std::memory_order_relaxed);
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+                stack_[depth - 1] = frame;
+                std::atomic_signal_fence(std::memory_order_release);
+                depth_.store(depth, std::memory_order_relaxed);
+            }
+        }
+
+        // Записывает текущий теневой стек как одну выборку. Вызывается обработчиком сигнала,
+        // а также может вызываться напрямую, например из встроенной функции
+        void Sample() noexcept;
+
+        [[nodiscard]] size_t GetSampleCount() const;
+        // Число выборок, не поместившихся в буфер
+        [[nodiscard]] size_t GetDroppedCount() const;
+
+        // Выводит свёрнутые стеки: "<module>;Class.method;function число_выборок" в каждой строке
+        void WriteFoldedStacks(std::ostream& out) const;
+        // Выводит таблицу собственного и полного времени методов, отсортированную по собственному
+        void WriteReport(std::ostream& out) const;
+
+    private:
+        static void HandleSignal(int signal);
+
+        std::chrono::microseconds interval_;
+        std::vector<ProfileFrame> stack_;
+        std::atomic<size_t> depth_ = 0;
+
+        // Выборки подряд: кадры от внешнего к внутреннему, затем кадр-разделитель со всеми
+        // нулевыми полями. Кадры глубже max_stack_depth не записываются
+        std::vector<ProfileFrame> samples_;
+        std::atomic<size_t> samples_size_ = 0;
+        std::atomic<size_t> sample_count_ = 0;
+        std::atomic<size_t> dropped_count_ = 0;
+        std::atomic<bool> sampling_ = false;
+
+        bool running_ = false;
+        timer_t timer_{};
+    };
+
+}  // namespace runtime
@@ -0,0 +1,105 @@
+#include "interpreter.h"
+#include "profiler.h"
+#include "test_runner.h"
+
+#include <sstream>
+
+using namespace std;
+using runtime::ObjectHolder;
+
+namespace {
+
+void TestShadowStack() {
+    runtime::Profiler profiler;
+    ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.GetContext().SetProfiler(&profiler);
+    // Выборка берётся явно, поэтому результат не зависит от таймера
+    interpreter.GetBuiltins().AddFunction("sample"s, {}, [&profiler](const vector<ObjectHolder>&, runtime::Context&) {
+        profiler.Sample();
+        return ObjectHolder::None();
+    });
+
+    istringstream program(R"(
+class Inner:
+  def work():
+    sample()
+
+class Outer:
+  def run(inner):
+    inner.work()
+    return inner.work()
+
+def helper():
+  sample()
+  return 0
+
+o = Outer()
+o.run(Inner())
+helper()
+sample()
+)");
+    interpreter.Load(program);
+    ASSERT_EQUAL(profiler.GetSampleCount(), 4U);
+
+    // Хвостовой вызов inner.work() замещает кадр Outer.run
+    ostringstream folded;
+    profiler.WriteFoldedStacks(folded);
+    ASSERT_EQUAL(folded.str(), "<module>;Inner.work;sample 1\n"
+                               "<module>;Outer.run;Inner.work;sample 1\n"
+                               "<module>;helper;sample 1\n"
+                               "<module>;sample 1\n"s);
+
+    ostringstream report;
+    profiler.WriteReport(report);
+    ASSERT_EQUAL(report.str(), "Samples: 4, interval 1000 us, dropped 0\n"
+                               "    self, ms   self %   total, ms  total %  name\n"
+                               "         4.0    100.0         4.0    100.0  sample\n"
+                               "         0.0      0.0         4.0    100.0  <module>\n"
+                               "         0.0      0.0         2.0     50.0  Inner.work\n"
+                               "         0.0      0.0         1.0     25.0  Outer.run\n"
+                               "         0.0      0.0         1.0     25.0  helper\n"s);
+}
+
+void TestTimerSampling() {
+    runtime::Profiler profiler(chrono::microseconds(500));
+    ostringstream output;
+    Interpreter interpreter(output);
+    interpreter.GetContext().SetProfiler(&profiler);
+
+    istringstream program(R"(
+def fib(n):
+  if n < 2:
+    return n
+  return fib(n - 1) + fib(n - 2)
+
+print fib(17)
+)");
+    profiler.Start();
+    interpreter.Load(program);
+    profiler.Stop();
+    ASSERT_EQUAL(output.str(), "1597\n"s);
+
+    ostringstream folded;
+    profiler.WriteFoldedStacks(folded);
+    ASSERT(profiler.GetSampleCount() > 0);
+    ASSERT(folded.str().find("<module>;fib;fib"s) != string::npos);
+}
+
+void TestOneProfilerPerThread() {
+    runtime::Profiler first;
+    runtime::Profiler second;
+    first.Start();
+    ASSERT_THROWS(second.Start(), runtime_error);
+    first.Stop();
+    second.Start();
+    second.Stop();
+}
+
+}  // namespace
+
+void RunProfilerTests(TestRunner& tr) {
+    RUN_TEST(tr, TestShadowStack);
+    RUN_TEST(tr, TestTimerSampling);
+    RUN_TEST(tr, TestOneProfilerPerThread);
+}
@@ -0,0 +1,59 @@
+#include "program_runner.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+void RunTask(const ProgramTask& task, ProgramResult& result, size_t max_call_depth,
+             const runtime::ExecutionLimits& limits) {
+    ostringstream output;
+    runtime::SimpleContext context{output};
+    context.SetMaxCallDepth(max_call_depth);
+    runtime::Closure closure = task.globals;
+
+    const auto start = chrono::steady_clock::now();
+    context.SetLimits(limits);
+    try {
+        runtime::LimitScope limit_scope(context);
+        task.program->Execute(closure, context);
+    } catch (const exception& e) {
+        result.error = task.source_map != nullptr ? parse::DescribeCurrentError(e, context, *task.source_map) : e.what();
+    } catch (...) {
+        result.error = "Unknown error"s;
+    }
+    result.duration = chrono::steady_clock::now() - start;
+    result.output = output.str();
+}
+
+}  // namespace
+
+vector<ProgramResult> RunPrograms(ThreadPool& pool, const vector<ProgramTask>& tasks,
+                                  size_t max_call_depth, const runtime::ExecutionLimits& limits) {
+    vector<ProgramResult> results(tasks.size());
+
+    // Ждём только свои задания, так как пул может выполнять и чужие
+    mutex done_mutex;
+    condition_variable done;
+    size_t remaining = tasks.size();
+
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        pool.Submit([&, i] {
+            RunTask(tasks[i], results[i], max_call_depth, limits);
+
+            lock_guard lock(done_mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        });
+    }
+
+    unique_lock lock(done_mutex);
+    done.wait(lock, [&remaining] {
+        return remaining == 0;
+    });
+    return results;
+}
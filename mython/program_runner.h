@@ -0,0 +1,38 @@
+#pragma once
+
+#include "runtime.h"
+#include "source_map.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Задание для параллельного выполнения: разобранная программа и начальные значения
+// её глобальных переменных
+struct ProgramTask {
+    const runtime::Executable* program = nullptr;
+    // Копируется перед выполнением. Объекты, на которые ссылаются значения, общие для всех
+    // копий, поэтому программа не должна их изменять (Number, String и Bool неизменяемы)
+    runtime::Closure globals;
+    // Участки исходного текста узлов program для позиций в сообщениях об ошибках (может быть nullptr)
+    const parse::SourceMap* source_map = nullptr;
+};
+
+struct ProgramResult {
+    // Вывод программы
+    std::string output;
+    // Текст исключения, если выполнение завершилось ошибкой, иначе пустая строка
+    std::string error;
+    std::chrono::steady_clock::duration duration{};
+};
+
+/*
+ * Выполняет задания tasks в потоках пула pool и возвращает результаты в порядке заданий.
+ * Каждое задание выполняется со своими Closure и Context, поэтому одну программу
+ * могут одновременно выполнять несколько заданий. Ограничения limits действуют
+ * на каждое задание отдельно
+ */
+std::vector<ProgramResult> RunPrograms(ThreadPool& pool, const std::vector<ProgramTask>& tasks,
+                                       size_t max_call_depth = runtime::Context::DEFAULT_MAX_CALL_DEPTH,
+                                       const runtime::ExecutionLimits& limits = {});
@@ -0,0 +1,340 @@
+#include "lexer.h"
+#include "parse.h"
+#include "program_runner.h"
+#include "scheduler.h"
+#include "test_runner.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using runtime::ObjectHolder;
+
+namespace {
+
+unique_ptr<runtime::Executable> Parse(const string& program) {
+    istringstream input(program);
+    parse::Lexer lexer(input);
+    return ParseProgram(lexer);
+}
+
+void TestThreadPool() {
+    atomic<int> counter = 0;
+    ThreadPool pool(3);
+    ASSERT_EQUAL(pool.GetThreadCount(), 3U);
+    for (int i = 0; i < 100; ++i) {
+        pool.Submit([&counter] {
+            ++counter;
+        });
+    }
+    pool.Wait();
+    ASSERT_EQUAL(counter.load(), 100);
+
+    // Пул без потоков не имеет смысла, поэтому создаётся хотя бы один поток
+    ThreadPool single(0);
+    ASSERT_EQUAL(single.GetThreadCount(), 1U);
+}
+
+void TestThreadPoolStealing() {
+    const int subtasks = 50;
+    atomic<int> done = 0;
+    ThreadPool pool(2);
+    // Подзадачи попадают в очередь занятого потока, поэтому выполнить их может
+    // только второй поток, забрав их себе
+    pool.Submit([&] {
+        for (int i = 0; i < subtasks; ++i) {
+            pool.Submit([&done] {
+                ++done;
+            });
+        }
+        while (done < subtasks) {
+            this_thread::yield();
+        }
+    });
+    pool.Wait();
+    ASSERT_EQUAL(done.load(), subtasks);
+    ASSERT_EQUAL(pool.GetStolenCount(), static_cast<size_t>(subtasks));
+}
+
+void TestThreadPoolIdleWorkers() {
+    atomic<int> counter = 0;
+    ThreadPool pool(4);
+    for (int round = 0; round < 20; ++round) {
+        // Между раундами все потоки засыпают; новые задачи должны их разбудить
+        this_thread::sleep_for(chrono::milliseconds(1));
+        for (int i = 0; i < 50; ++i) {
+            pool.Submit([&pool, &counter] {
+                pool.Submit([&counter] {
+                    ++counter;
+                });
+                ++counter;
+            });
+        }
+        pool.Wait();
+        ASSERT_EQUAL(counter.load(), (round + 1) * 100);
+    }
+}
+
+void TestRunPrograms() {
+    auto program = Parse(R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def add(n):
+    self.value = self.value + n
+
+c = Counter()
+for i in range(0, n):
+  c.add(i)
+print name, c.value
+)");
+
+    vector<ProgramTask> tasks(20);
+    for (int i = 0; i < 20; ++i) {
+        tasks[i].program = program.get();
+        tasks[i].globals["n"s] = ObjectHolder::Own(runtime::Number{i});
+        tasks[i].globals["name"s] = ObjectHolder::Own(runtime::String{"task"s + to_string(i)});
+    }
+
+    ThreadPool pool(4);
+    const auto results = RunPrograms(pool, tasks);
+    ASSERT_EQUAL(results.size(), tasks.size());
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQUAL(results[i].output, "task"s + to_string(i) + " "s + to_string(i * (i - 1) / 2) + "\n"s);
+        ASSERT(results[i].error.empty());
+    }
+}
+
+void TestRunProgramsErrors() {
+    auto program = Parse(R"(
+print 'start'
+print 10 / d
+)");
+    auto recursive = Parse(R"(
+def f(n):
+  return f(n + 1) + 1
+
+f(0)
+)");
+
+    vector<ProgramTask> tasks(3);
+    tasks[0].program = program.get();
+    tasks[0].globals["d"s] = ObjectHolder::Own(runtime::Number{2});
+    tasks[1].program = program.get();
+    tasks[1].globals["d"s] = ObjectHolder::Own(runtime::Number{0});
+    tasks[2].program = recursive.get();
+
+    ThreadPool pool(2);
+    const auto results = RunPrograms(pool, tasks, 50);
+    ASSERT_EQUAL(results[0].output, "start\n5\n"s);
+    ASSERT(results[0].error.empty());
+    // Вывод, сделанный до ошибки, сохраняется
+    ASSERT_EQUAL(results[1].output, "start\n"s);
+    ASSERT(!results[1].error.empty());
+    ASSERT(!results[2].error.empty());
+}
+
+void TestRunProgramsLimits() {
+    auto program = Parse(R"(
+s = 'x'
+for i in range(n):
+  s = s + s
+print len(s)
+)");
+
+    vector<ProgramTask> tasks(3);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i].program = program.get();
+    }
+    tasks[0].globals["n"s] = ObjectHolder::Own(runtime::Number{4});
+    tasks[1].globals["n"s] = ObjectHolder::Own(runtime::Number{40});
+    tasks[2].globals["n"s] = ObjectHolder::Own(runtime::Number{4});
+
+    runtime::ExecutionLimits limits;
+    limits.max_heap_bytes = 1 << 20;
+    limits.max_steps = 100;
+    ThreadPool pool(2);
+    const auto results = RunPrograms(pool, tasks, 50, limits);
+    // Ограничения действуют на каждое задание отдельно, поэтому ошибка одного не мешает другим
+    ASSERT_EQUAL(results[0].output, "16\n"s);
+    ASSERT(results[1].error.find("Memory limit exceeded"s) != string::npos);
+    ASSERT_EQUAL(results[2].output, "16\n"s);
+}
+
+void TestPreemptiveInterleaving() {
+    // Первая программа ждёт, пока вторая не изменит общий список. Без вытеснения единственный
+    // поток навсегда остался бы в цикле первой программы
+    auto waiter = Parse(R"(
+spins = 0
+while flag[0] == 0:
+  spins = spins + 1
+print 'done'
+)");
+    auto setter = Parse(R"(
+flag[0] = 1
+print 'set'
+)");
+
+    vector<ProgramTask> tasks(2);
+    tasks[0].program = waiter.get();
+    tasks[1].program = setter.get();
+    const ObjectHolder flag = ObjectHolder::Own(runtime::List{{ObjectHolder::Own(runtime::Number{0})}});
+    tasks[0].globals["flag"s] = flag;
+    tasks[1].globals["flag"s] = flag;
+
+    SchedulerOptions options;
+    options.slice_steps = 10;
+    options.limits.max_steps = 1'000'000;
+    const auto results = RunProgramsPreemptive(tasks, options);
+    ASSERT_EQUAL(results[0].output, "done\n"s);
+    ASSERT(results[0].error.empty());
+    ASSERT_EQUAL(results[1].output, "set\n"s);
+}
+
+void TestPreemptiveManyPrograms() {
+    auto program = Parse(R"(
+def sum(n):
+  if n == 0:
+    return 0
+  return n + sum(n - 1)
+
+total = 0
+for i in range(n):
+  total = total + sum(i)
+print name, total
+)");
+
+    vector<ProgramTask> tasks(50);
+    for (int i = 0; i < 50; ++i) {
+        tasks[i].program = program.get();
+        tasks[i].globals["n"s] = ObjectHolder::Own(runtime::Number{i * 5});
+        tasks[i].globals["name"s] = ObjectHolder::Own(runtime::String{"task"s + to_string(i)});
+    }
+
+    SchedulerOptions options;
+    options.threads = 3;
+    options.slice_steps = 7;
+    const auto results = RunProgramsPreemptive(tasks, options);
+    ASSERT_EQUAL(results.size(), tasks.size());
+    for (int i = 0; i < 50; ++i) {
+        const int n = i * 5;
+        ASSERT_EQUAL(results[i].output, "task"s + to_string(i) + " "s + to_string((n - 1) * n * (n + 1) / 6) + "\n"s);
+        ASSERT(results[i].error.empty());
+    }
+}
+
+void TestPreemptiveBoundedPrograms() {
+    // Программы отмечают в общем списке начало и конец своего выполнения
+    auto program = Parse(R"(
+log.append('start ' + name)
+for i in range(50):
+  x = i
+log.append('end ' + name)
+)");
+
+    vector<ProgramTask> tasks(6);
+    const ObjectHolder log = ObjectHolder::Own(runtime::List{});
+    for (int i = 0; i < 6; ++i) {
+        tasks[i].program = program.get();
+        tasks[i].globals["log"s] = log;
+        tasks[i].globals["name"s] = ObjectHolder::Own(runtime::String{to_string(i)});
+    }
+
+    SchedulerOptions options;
+    options.slice_steps = 10;
+    options.max_programs_per_thread = 2;
+    const auto results = RunProgramsPreemptive(tasks, options);
+    for (const ProgramResult& result : results) {
+        ASSERT(result.error.empty());
+    }
+
+    vector<string> events;
+    for (const ObjectHolder& event : log.TryAs<runtime::List>()->Values()) {
+        events.push_back(event.TryAs<runtime::String>()->GetValue());
+    }
+    ASSERT_EQUAL(events.size(), 12U);
+    // Одновременно начато не больше двух программ, а первая завершается раньше, чем
+    // начинается последняя
+    size_t running = 0;
+    for (const string& event : events) {
+        running = event.substr(0, 5) == "start"s ? running + 1 : running - 1;
+        ASSERT(running <= 2U);
+    }
+    ASSERT_EQUAL(events[0], "start 0"s);
+    ASSERT(find(events.begin(), events.end(), "end 0"s) < find(events.begin(), events.end(), "start 5"s));
+}
+
+void TestPreemptiveErrorsAndLimits() {
+    auto recursive = Parse(R"(
+def f(n):
+  return f(n + 1) + 1
+
+f(0)
+)");
+    auto endless = Parse(R"(
+while True:
+  x = 1
+)");
+    auto program = Parse("print 10 / d\n"s);
+    // Вложенные выражения расходуют стек на каждом уровне рекурсии
+    string expression = "f(n - 1)"s;
+    for (int i = 0; i < 30; ++i) {
+        expression = "(1 + "s + expression + ")"s;
+    }
+    auto nested = Parse("def f(n):\n  if n == 0:\n    return 0\n  return "s + expression + "\n\nprint f(10)\nprint f(5000)\n"s);
+    // Выражение без вызовов методов, вложенность которого превышает стек программы
+    string deep_expression = "y"s;
+    for (int i = 0; i < 6000; ++i) {
+        deep_expression = "(y + "s + deep_expression + ")"s;
+    }
+    auto deep = Parse("y = 1\nprint 'start'\nx = "s + deep_expression + "\nprint x\n"s);
+
+    vector<ProgramTask> tasks(6);
+    tasks[0].program = recursive.get();
+    tasks[1].program = endless.get();
+    tasks[2].program = program.get();
+    tasks[2].globals["d"s] = ObjectHolder::Own(runtime::Number{0});
+    tasks[3].program = program.get();
+    tasks[3].globals["d"s] = ObjectHolder::Own(runtime::Number{5});
+    tasks[4].program = nested.get();
+    tasks[5].program = deep.get();
+
+    SchedulerOptions options;
+    options.threads = 2;
+    options.slice_steps = 100;
+    // Глубину вызовов ограничивает размер стека программы: переполнение стека - ошибка задания,
+    // а не аварийное завершение процесса
+    options.stack_size = 512 * 1024;
+    options.max_call_depth = 100'000;
+    options.limits.max_steps = 50'000;
+    const auto results = RunProgramsPreemptive(tasks, options);
+    ASSERT(results[0].error.find("Maximum recursion depth exceeded"s) != string::npos);
+    ASSERT(results[1].error.find("Step limit exceeded"s) != string::npos);
+    ASSERT(!results[2].error.empty());
+    ASSERT_EQUAL(results[3].output, "2\n"s);
+    ASSERT(results[3].error.empty());
+    ASSERT_EQUAL(results[4].output, "300\n"s);
+    ASSERT(results[4].error.find("Maximum recursion depth exceeded"s) != string::npos);
+    ASSERT_EQUAL(results[5].output, "start\n"s);
+    ASSERT(results[5].error.find("Maximum recursion depth exceeded: expression nesting is too deep"s) != string::npos);
+}
+
+}  // namespace
+
+void RunProgramRunnerTests(TestRunner& tr) {
+    RUN_TEST(tr, TestThreadPool);
+    RUN_TEST(tr, TestThreadPoolStealing);
+    RUN_TEST(tr, TestThreadPoolIdleWorkers);
+    RUN_TEST(tr, TestRunPrograms);
+    RUN_TEST(tr, TestRunProgramsErrors);
+    RUN_TEST(tr, TestRunProgramsLimits);
+    RUN_TEST(tr, TestPreemptiveInterleaving);
+    RUN_TEST(tr, TestPreemptiveManyPrograms);
+    RUN_TEST(tr, TestPreemptiveBoundedPrograms);
+    RUN_TEST(tr, TestPreemptiveErrorsAndLimits);
+}
@@ -0,0 +1,136 @@
+#include "record_output.h"
+
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        void AppendVarint(string& out, uint64_t value) {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void AppendBytes(string& out, RecordTag tag, const string& text) {
+            out.push_back(static_cast<char>(tag));
+            AppendVarint(out, text.size());
+            out += text;
+        }
+
+        uint64_t ReadVarint(istream& input) {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                const int byte = input.get();
+                if (byte == istream::traits_type::eof())
+                {
+                    throw runtime_error("Unexpected end of record stream"s);
+                }
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            throw runtime_error("Invalid varint in record stream"s);
+        }
+
+        string ReadBytes(istream& input) {
+            string text(ReadVarint(input), '\0');
+            if (!input.read(text.data(), static_cast<streamsize>(text.size())))
+            {
+                throw runtime_error("Unexpected end of record stream"s);
+            }
+            return text;
+        }
+    }  // namespace
+
+    void RecordWriter::Write(const vector<ObjectHolder>& values, Context& context) {
+        // Текст прочих объектов получаем заранее: __str__ может сам выполнить print
+        vector<string> texts;
+        for (const ObjectHolder& value : values)
+        {
+            const ObjectType type = value ? value->GetType() : ObjectType::Other;
+            if (value && type != ObjectType::Number && type != ObjectType::String && type != ObjectType::Bool)
+            {
+                ostringstream text;
+                value->Print(text, context);
+                texts.push_back(text.str());
+            }
+        }
+
+        buffer_.clear();
+        AppendVarint(buffer_, values.size());
+        auto next_text = texts.begin();
+        for (const ObjectHolder& value : values)
+        {
+            if (!value)
+            {
+                buffer_.push_back(static_cast<char>(RecordTag::None));
+            }
+            else if (const Number* number = value.TryAs<Number>())
+            {
+                const auto n = static_cast<uint32_t>(number->GetValue());
+                buffer_.push_back(static_cast<char>(RecordTag::Number));
+                AppendVarint(buffer_, (n << 1) ^ (number->GetValue() < 0 ? UINT32_MAX : 0));
+            }
+            else if (const String* str = value.TryAs<String>())
+            {
+                AppendBytes(buffer_, RecordTag::String, str->GetValue());
+            }
+            else if (const Bool* boolean = value.TryAs<Bool>())
+            {
+                buffer_.push_back(static_cast<char>(boolean->GetValue() ? RecordTag::True : RecordTag::False));
+            }
+            else
+            {
+                AppendBytes(buffer_, RecordTag::Text, *next_text++);
+            }
+        }
+        context.GetOutputStream().write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+    }
+
+    bool ReadRecord(istream& input, vector<RecordValue>& values) {
+        values.clear();
+        if (input.peek() == istream::traits_type::eof())
+        {
+            return false;
+        }
+        const uint64_t count = ReadVarint(input);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            const int tag = input.get();
+            RecordValue& value = values.emplace_back();
+            value.tag = static_cast<RecordTag>(tag);
+            switch (value.tag)
+            {
+            case RecordTag::None:
+            case RecordTag::False:
+            case RecordTag::True:
+                break;
+            case RecordTag::Number:
+            {
+                const auto n = static_cast<uint32_t>(ReadVarint(input));
+                value.number = static_cast<int>((n >> 1) ^ (0U - (n & 1)));
+                break;
+            }
+            case RecordTag::String:
+            case RecordTag::Text:
+                value.text = ReadBytes(input);
+                break;
+            default:
+                throw runtime_error(tag == istream::traits_type::eof() ? "Unexpected end of record stream"s
+                                                                        : "Unknown tag in record stream: "s + to_string(tag));
+            }
+        }
+        return true;
+    }
+
+}  // namespace runtime
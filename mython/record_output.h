@@ -0,0 +1,62 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+    /*
+     * Двоичный формат вывода команды print: каждая команда записывает одну запись
+     *
+     *   запись   := varint(число значений) значение*
+     *   значение := тег [данные]
+     *
+     * varint — беззнаковое число в формате LEB128 (по 7 бит, младшие первыми).
+     * Теги и данные:
+     *   None   (0) — без данных;
+     *   Number (1) — число в формате zigzag varint;
+     *   String (2) — varint(длина) и байты строки;
+     *   False  (3), True (4) — без данных;
+     *   Text   (5) — varint(длина) и текст, который вывел бы Object::Print
+     *                (экземпляры классов, списки, словари, классы, функции)
+     */
+    enum class RecordTag : unsigned char {
+        None,
+        Number,
+        String,
+        False,
+        True,
+        Text,
+    };
+
+    /*
+     * Записывает значения команд print в двоичном формате в поток вывода контекста.
+     * Подключается к контексту через Context::SetRecordWriter.
+     *
+     * Все аргументы print вычисляются до записи, а текст объектов с Text — до кодирования
+     * записи, поэтому print, выполненный внутри __str__ или методов из аргументов, записывает
+     * свою запись целиком перед записью внешней команды
+     */
+    class RecordWriter {
+    public:
+        void Write(const std::vector<ObjectHolder>& values, Context& context);
+
+    private:
+        std::string buffer_;
+    };
+
+    struct RecordValue {
+        RecordTag tag = RecordTag::None;
+        int number = 0;
+        // Данные String и Text
+        std::string text;
+    };
+
+    // Читает из input одну запись в values. Возвращает false, если поток закончился до начала
+    // записи. Если запись оборвана или содержит неизвестный тег, выбрасывает runtime_error
+    bool ReadRecord(std::istream& input, std::vector<RecordValue>& values);
+
+}  // namespace runtime
@@ -0,0 +1,84 @@
+#include "interpreter.h"
+#include "record_output.h"
+#include "test_runner.h"
+
+#include <sstream>
+
+using namespace std;
+using runtime::RecordTag;
+using runtime::RecordValue;
+
+namespace {
+
+vector<vector<RecordValue>> ReadAll(const string& data) {
+    istringstream input(data);
+    vector<vector<RecordValue>> records;
+    vector<RecordValue> values;
+    while (runtime::ReadRecord(input, values)) {
+        records.push_back(values);
+    }
+    return records;
+}
+
+void TestPrintRecords() {
+    ostringstream output;
+    runtime::RecordWriter record_writer;
+    Interpreter interpreter(output);
+    interpreter.GetContext().SetRecordWriter(&record_writer);
+
+    istringstream program(R"(
+class Point:
+  def __init__(x):
+    self.x = x
+
+  def __str__():
+    print 'inner'
+    return 'Point(' + str(self.x) + ')'
+
+print 0, -1, 300, 'text', True, False, None
+print
+print [1, 2], Point(7)
+)");
+    interpreter.Load(program);
+
+    const auto records = ReadAll(output.str());
+    ASSERT_EQUAL(records.size(), 4u);
+
+    const auto& first = records[0];
+    ASSERT_EQUAL(first.size(), 7u);
+    ASSERT(first[0].tag == RecordTag::Number && first[0].number == 0);
+    ASSERT(first[1].tag == RecordTag::Number && first[1].number == -1);
+    ASSERT(first[2].tag == RecordTag::Number && first[2].number == 300);
+    ASSERT(first[3].tag == RecordTag::String && first[3].text == "text"s);
+    ASSERT(first[4].tag == RecordTag::True);
+    ASSERT(first[5].tag == RecordTag::False);
+    ASSERT(first[6].tag == RecordTag::None);
+    ASSERT(records[1].empty());
+
+    // print из __str__ записывается целиком до внешней записи
+    ASSERT_EQUAL(records[2].size(), 1u);
+    ASSERT_EQUAL(records[2][0].text, "inner"s);
+    ASSERT_EQUAL(records[3].size(), 2u);
+    ASSERT(records[3][0].tag == RecordTag::Text && records[3][0].text == "[1, 2]"s);
+    ASSERT(records[3][1].tag == RecordTag::Text && records[3][1].text == "Point(7)"s);
+
+    // Небольшие числа занимают два байта, число значений - один
+    ASSERT_EQUAL(output.str().substr(0, 5), "\x07\x01\x00\x01\x01"s);
+}
+
+void TestMalformedRecords() {
+    vector<RecordValue> values;
+    istringstream truncated("\x02\x01"s);
+    ASSERT_THROWS(runtime::ReadRecord(truncated, values), runtime_error);
+    istringstream unknown_tag("\x01\x09"s);
+    ASSERT_THROWS(runtime::ReadRecord(unknown_tag, values), runtime_error);
+    istringstream short_string("\x01\x02\x05" "ab"s);
+    ASSERT_THROWS(runtime::ReadRecord(short_string, values), runtime_error);
+}
+
+}  // namespace
+
+void RunRecordOutputTests(TestRunner& tr) {
+    RUN_TEST(tr, TestPrintRecords);
+    RUN_TEST(tr, TestMalformedRecords);
+}
@@ -1,6 +1,12 @@
 #include "runtime.h"
+#include "profiler.h"
+#include "statistics.h"
 
+#include <pthread.h>
+
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <optional>
 #include <sstream>
 
@@ -17,14 +23,61 @@ namespace runtime {
     }
 
     ObjectHolder ObjectHolder::Share(Object& object) {
-        // Возвращаем невладеющий shared_ptr (его deleter ничего не делает)
-        return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
+        // Возвращаем невладеющий shared_ptr. Конструктор псевдонима с пустым владельцем
+        // не создаёт блок управления, поэтому копирование такого ObjectHolder не трогает счётчик ссылок
+        return ObjectHolder(std::shared_ptr<Object>(std::shared_ptr<Object>{}, &object));
     }
 
     ObjectHolder ObjectHolder::None() {
         return ObjectHolder();
     }
 
+    namespace {
+        // Неуничтожаемые объекты создаются при первом обращении и живут до завершения процесса
+        Bool& TrueObject() {
+            static Bool* const value = new Bool(true);
+            return *value;
+        }
+
+        Bool& FalseObject() {
+            static Bool* const value = new Bool(false);
+            return *value;
+        }
+
+        std::vector<Number>& SmallNumbers() {
+            static std::vector<Number>* const cache = [] {
+                auto numbers = new std::vector<Number>();
+                numbers->reserve(ObjectHolder::SMALL_NUMBER_MAX - ObjectHolder::SMALL_NUMBER_MIN + 1);
+                for (int value = ObjectHolder::SMALL_NUMBER_MIN; value <= ObjectHolder::SMALL_NUMBER_MAX; ++value)
+                {
+                    numbers->emplace_back(value);
+                }
+                return numbers;
+            }();
+            return *cache;
+        }
+    }  // namespace
+
+    ObjectHolder ObjectHolder::True() {
+        return Share(TrueObject());
+    }
+
+    ObjectHolder ObjectHolder::False() {
+        return Share(FalseObject());
+    }
+
+    ObjectHolder ObjectHolder::FromBool(bool value) {
+        return value ? True() : False();
+    }
+
+    ObjectHolder ObjectHolder::FromNumber(int value) {
+        if ((value >= SMALL_NUMBER_MIN) && (value <= SMALL_NUMBER_MAX))
+        {
+            return Share(SmallNumbers()[value - SMALL_NUMBER_MIN]);
+        }
+        return Own(Number{ value });
+    }
+
     Object& ObjectHolder::operator*() const {
         AssertIsValid();
         return *Get();
@@ -48,13 +101,22 @@ namespace runtime {
         {
             return false;
         }
-        if (((object.TryAs<Number>() != nullptr) && (object.TryAs<Number>()->GetValue() != 0))    // если Number и не ноль
-            || ((object.TryAs<Bool>() != nullptr) && (object.TryAs<Bool>()->GetValue() == true))    //  если Bool и true
-            || ((object.TryAs<String>() != nullptr) && (object.TryAs<String>()->GetValue().size() != 0)))   // если  не пустая строка
+        // Тип определяем по метке объекта, без цепочки dynamic_cast
+        switch (object->GetType())
         {
-            return true;
+        case ObjectType::Number:
+            return static_cast<const Number&>(*object).GetValue() != 0;
+        case ObjectType::Bool:
+            return static_cast<const Bool&>(*object).GetValue();
+        case ObjectType::String:
+            return !static_cast<const String&>(*object).GetValue().empty();
+        case ObjectType::List:
+            return static_cast<const List&>(*object).Size() != 0;
+        case ObjectType::Dict:
+            return static_cast<const Dict&>(*object).Size() != 0;
+        default:
+            return false;
         }
-        return false;
     }
 
     void ClassInstance::Print(std::ostream& os, Context& context) {
@@ -92,25 +154,227 @@ namespace runtime {
         return fields_;
     }
 
-    ClassInstance::ClassInstance(const Class& cls) :class_(cls){
+    ClassInstance::ClassInstance(const Class& cls) : Object(ObjectType::ClassInstance), class_(cls){
+    }
+
+    namespace {
+        // Выполняет тело функции, не разворачивая хвостовые вызовы
+        ObjectHolder InvokeFunction(const Function& function, const std::vector<ObjectHolder>& actual_args,
+            Context& context) {
+            if (actual_args.size() != function.formal_params.size())
+            {
+                throw std::runtime_error("Function "s + function.name + " takes "s
+                    + std::to_string(function.formal_params.size()) + " arguments"s);
+            }
+            if (function.native)
+            {
+                return function.native(actual_args, context);
+            }
+            Closure closure;
+            for (size_t i = 0; i < actual_args.size(); ++i)
+            {
+                closure[function.formal_params[i]] = actual_args[i];
+            }
+            ObjectHolder result = function.body->Execute(closure, context);
+            if (Statistics* statistics = context.GetStatistics())
+            {
+                statistics->NoteClosureSize(closure.size());
+            }
+            return result;
+        }
+
+        // Хвостовые вызовы выполняем в цикле вместо рекурсии.
+        // Объект TailCall остаётся в result, пока выполняется его вызов, и удерживает вызываемый объект
+        ObjectHolder RunTailCalls(ObjectHolder result, Context& context) {
+            while (auto tail_call = result.TryAs<TailCall>())
+            {
+                context.Step();
+                result = tail_call->Invoke(context);
+            }
+            return result;
+        }
+
+        // Отмечает в контексте вход в метод на время своего существования.
+        // Если к контексту подключён профилировщик, кадр make_frame() помещается в его теневой стек
+        class CallDepthGuard {
+        public:
+            template <typename MakeFrame>
+            CallDepthGuard(Context& context, MakeFrame make_frame)
+                : context_(context), profiler_(context.GetProfiler()) {
+                context_.EnterCall();
+                if (profiler_ != nullptr)
+                {
+                    profiler_->Enter(make_frame());
+                }
+            }
+
+            CallDepthGuard(const CallDepthGuard&) = delete;
+            CallDepthGuard& operator=(const CallDepthGuard&) = delete;
+
+            ~CallDepthGuard() {
+                if (profiler_ != nullptr)
+                {
+                    profiler_->Leave();
+                }
+                context_.LeaveCall();
+            }
+
+        private:
+            Context& context_;
+            Profiler* profiler_;
+        };
+    }  // namespace
+
+    void Context::SetLimits(const ExecutionLimits& limits) {
+        limits_ = limits;
+        steps_ = 0;
+        next_yield_ = yield_slice_;
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        if (limits_.timeout > std::chrono::steady_clock::duration::zero())
+        {
+            // Время, которое не может закончиться, не должно переполнять deadline_
+            const auto now = std::chrono::steady_clock::now();
+            if (limits_.timeout < deadline_ - now)
+            {
+                deadline_ = now + limits_.timeout;
+            }
+        }
+        chunk_ = fuel_ = NextChunk();
+        heap_ = limits_.max_heap_bytes > 0 ? std::make_shared<HeapAccount>(limits_.max_heap_bytes) : nullptr;
+    }
+
+    void Context::SetYield(uint64_t slice_steps, std::function<void()> yield) {
+        steps_ = GetStepCount();
+        yield_slice_ = yield ? std::max<uint64_t>(slice_steps, 1) : 0;
+        yield_ = std::move(yield);
+        next_yield_ = steps_ + yield_slice_;
+        chunk_ = fuel_ = NextChunk();
+    }
+
+    uint64_t Context::NextChunk() const {
+        uint64_t chunk = UINT64_MAX;
+        if (limits_.max_steps > 0)
+        {
+            chunk = std::min(chunk, limits_.max_steps - steps_ + 1);
+        }
+        if (deadline_ != std::chrono::steady_clock::time_point::max())
+        {
+            chunk = std::min(chunk, STEP_CHECK_INTERVAL);
+        }
+        if (yield_)
+        {
+            chunk = std::min(chunk, next_yield_ - steps_);
+        }
+        return chunk;
+    }
+
+    void Context::Refuel() {
+        steps_ += chunk_;
+        // Пока ограничение превышено, каждый следующий шаг снова выбрасывает ошибку
+        chunk_ = fuel_ = 1;
+        if (limits_.max_steps > 0 && steps_ > limits_.max_steps)
+        {
+            steps_ = limits_.max_steps;
+            throw LimitError("Step limit exceeded: "s + std::to_string(limits_.max_steps));
+        }
+        if (std::chrono::steady_clock::now() >= deadline_)
+        {
+            throw LimitError("Time limit exceeded: "s
+                + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(limits_.timeout).count())
+                + " ms"s);
+        }
+        if (yield_ && steps_ >= next_yield_)
+        {
+            next_yield_ = steps_ + yield_slice_;
+            yield_();
+        }
+        chunk_ = fuel_ = NextChunk();
+    }
+
+    void HeapAccount::Charge(size_t bytes) {
+        const size_t used = used_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        if (used > limit_)
+        {
+            used_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+            throw LimitError("Memory limit exceeded: "s + std::to_string(limit_) + " bytes"s);
+        }
+    }
+
+    uintptr_t FindThreadStackLimit() {
+        pthread_attr_t attr;
+        if (pthread_getattr_np(pthread_self(), &attr) == 0)
+        {
+            void* stack_addr = nullptr;
+            size_t stack_size = 0;
+            const int result = pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+            pthread_attr_destroy(&attr);
+            if (result == 0 && stack_size > STACK_RESERVE)
+            {
+                return reinterpret_cast<uintptr_t>(stack_addr) + STACK_RESERVE;
+            }
+        }
+        // Размер стека неизвестен: рассчитываем на наименьший размер стека потока по умолчанию
+        const char marker = 0;
+        return reinterpret_cast<uintptr_t>(&marker) - std::min<uintptr_t>(reinterpret_cast<uintptr_t>(&marker), 1 << 20);
+    }
+
+    void ThrowExpressionTooDeep() {
+        throw RecursionError("Maximum recursion depth exceeded: expression nesting is too deep"s);
+    }
+
+    void Context::EnterCall() {
+        Step();
+        if (call_depth_ >= max_call_depth_)
+        {
+            throw RecursionError("Maximum recursion depth exceeded: "s + std::to_string(max_call_depth_));
+        }
+        if (IsStackExhausted())
+        {
+            throw RecursionError("Maximum recursion depth exceeded: stack exhausted at depth "s
+                                 + std::to_string(call_depth_));
+        }
+        ++call_depth_;
     }
 
     ObjectHolder ClassInstance::Call(const std::string& method,
+        const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+        CallDepthGuard depth_guard(context, [this, &method] {
+            return ProfileFrame{&class_, class_.GetMethod(method)};
+        });
+        if (Statistics* statistics = context.GetStatistics())
+        {
+            statistics->NoteMethodCall();
+        }
+        return RunTailCalls(Invoke(method, actual_args, context), context);
+    }
+
+    ObjectHolder ClassInstance::Invoke(const std::string& method,
         const std::vector<ObjectHolder>& actual_args,
         Context& context) {
         if (this->HasMethod(method, actual_args.size()))
         {
-            // параметр self аналог указателя this в C++  
-            Closure closure = { {"self", ObjectHolder::Share(*this)} };
             // Получаем указатель на метод из таблицы виртуальных функций
             auto method_ptr = class_.GetMethod(method);
+            if (method_ptr->native)
+            {
+                return method_ptr->native(*this, actual_args, context);
+            }
+            // параметр self аналог указателя this в C++  
+            std::shared_ptr<ClassInstance> owner = weak_from_this().lock();
+            Closure closure = { {"self", owner ? ObjectHolder(std::move(owner)) : ObjectHolder::Share(*this)} };
 
             for (size_t i = 0; i < method_ptr->formal_params.size(); ++i)
             {
                 std::string arg = method_ptr->formal_params[i];
                 closure[arg] = actual_args[i];//имя_параметра = значение_параметра
             }
-            return method_ptr->body->Execute(closure, context);
+            ObjectHolder result = method_ptr->body->Execute(closure, context);
+            if (Statistics* statistics = context.GetStatistics())
+            {
+                statistics->NoteClosureSize(closure.size());
+            }
+            return result;
         }
         else
         {
@@ -118,8 +382,154 @@ namespace runtime {
         }
     }
 
+    ObjectHolder CallFunction(const Function& function, const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+        CallDepthGuard depth_guard(context, [&function] {
+            return ProfileFrame{nullptr, nullptr, &function};
+        });
+        if (Statistics* statistics = context.GetStatistics())
+        {
+            statistics->NoteFunctionCall();
+        }
+        return RunTailCalls(InvokeFunction(function, actual_args, context), context);
+    }
+
+    void Function::Print(std::ostream& os, [[maybe_unused]] Context& context) {
+        os << "Function "sv << name;
+    }
+
+    Builtins::Builtins(const Builtins* parent)
+        : parent_(parent)
+    {
+    }
+
+    const Function& Builtins::AddFunction(std::string name, std::vector<std::string> params,
+        NativeFunction native) {
+        if (FindFunction(name) != nullptr)
+        {
+            throw std::runtime_error("Builtin function "s + name + " already exists"s);
+        }
+        auto function = std::make_unique<Function>();
+        function->name = std::move(name);
+        function->formal_params = std::move(params);
+        function->native = std::move(native);
+        functions_.push_back(std::move(function));
+        return *functions_.back();
+    }
+
+    const Class& Builtins::AddClass(std::string name, std::vector<Method> methods, const Class* parent) {
+        if (FindClass(name) != nullptr)
+        {
+            throw std::runtime_error("Builtin class "s + name + " already exists"s);
+        }
+        classes_.push_back(std::make_unique<Class>(std::move(name), std::move(methods), parent));
+        return *classes_.back();
+    }
+
+    Function* Builtins::FindFunction(const std::string& name) const {
+        if (parent_ != nullptr)
+        {
+            if (Function* function = parent_->FindFunction(name))
+            {
+                return function;
+            }
+        }
+        for (const auto& function : functions_)
+        {
+            if (function->name == name)
+            {
+                return function.get();
+            }
+        }
+        return nullptr;
+    }
+
+    Class* Builtins::FindClass(const std::string& name) const {
+        if (parent_ != nullptr)
+        {
+            if (Class* cls = parent_->FindClass(name))
+            {
+                return cls;
+            }
+        }
+        for (const auto& cls : classes_)
+        {
+            if (cls->GetName() == name)
+            {
+                return cls.get();
+            }
+        }
+        return nullptr;
+    }
+
+    const std::vector<std::unique_ptr<Function>>& Builtins::GetFunctions() const {
+        return functions_;
+    }
+
+    const std::vector<std::unique_ptr<Class>>& Builtins::GetClasses() const {
+        return classes_;
+    }
+
+    const Builtins* Builtins::GetParent() const {
+        return parent_;
+    }
+
+    TailCall::TailCall(ObjectHolder object, std::string method, std::vector<ObjectHolder> args)
+        : Object(ObjectType::TailCall), object_(std::move(object)), method_(std::move(method)), args_(std::move(args)) {
+    }
+
+    TailCall::TailCall(const Function& function, std::vector<ObjectHolder> args)
+        : Object(ObjectType::TailCall), method_(function.name), function_(&function), args_(std::move(args)) {
+    }
+
+    void TailCall::Print(std::ostream& os, [[maybe_unused]] Context& context) {
+        os << "TailCall "sv << method_;
+    }
+
+    ObjectHolder TailCall::Invoke(Context& context) {
+        if (Statistics* statistics = context.GetStatistics())
+        {
+            statistics->NoteTailCall();
+        }
+        Profiler* profiler = context.GetProfiler();
+        if (function_ != nullptr)
+        {
+            if (profiler != nullptr)
+            {
+                profiler->Replace(ProfileFrame{nullptr, nullptr, function_});
+            }
+            return InvokeFunction(*function_, args_, context);
+        }
+        auto instance = object_.TryAs<ClassInstance>();
+        if (instance == nullptr)
+        {
+            return ObjectHolder::None();
+        }
+        if (profiler != nullptr)
+        {
+            profiler->Replace(ProfileFrame{&instance->class_, instance->class_.GetMethod(method_)});
+        }
+        return instance->Invoke(method_, args_, context);
+    }
+
+    const Function* TailCall::GetFunction() const {
+        return function_;
+    }
+
+    const ObjectHolder& TailCall::GetObject() const {
+        return object_;
+    }
+
+    const std::string& TailCall::GetMethod() const {
+        return method_;
+    }
+
+    std::vector<ObjectHolder>& TailCall::GetArgs() {
+        return args_;
+    }
+
     Class::Class(std::string name, std::vector<Method> methods, const Class* parent) : 
-        name_(std::move(name)), methods_(std::move(methods)), parent_(std::move(parent)) {
+        Object(ObjectType::Class), name_(std::move(name)), methods_(std::move(methods)), parent_(std::move(parent)) {
         if (parent_ != nullptr)
         {
             //запмсываем в vtable родительские методы
@@ -151,117 +561,512 @@ namespace runtime {
         os << "Class "sv << GetName();
     }
 
-    void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
-        os << (GetValue() ? "True"sv : "False"sv);
+    namespace {
+        // Выводит элемент коллекции: строки - в одинарных кавычках, пустое значение - как None
+        void PrintRepr(std::ostream& os, const ObjectHolder& value, Context& context) {
+            if (!value)
+            {
+                os << "None"sv;
+            }
+            else if (auto str_ptr = value.TryAs<String>())
+            {
+                os << '\'' << str_ptr->GetValue() << '\'';
+            }
+            else
+            {
+                value->Print(os, context);
+            }
+        }
+    }  // namespace
+
+    List::List() : Object(ObjectType::List) {
     }
 
+    List::List(std::vector<ObjectHolder> values) : Object(ObjectType::List), values_(std::move(values)) {
+        heap_charge_.Update(values_.capacity() * sizeof(ObjectHolder));
+    }
 
-    bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        // lhs и rhs это None возвращаем true.
-        if (!lhs && !rhs)
+    void List::Print(std::ostream& os, Context& context) {
+        os << '[';
+        bool first = true;
+        for (const auto& value : values_)
         {
-            return true;
+            if (!first)
+            {
+                os << ", "sv;
+            }
+            first = false;
+            PrintRepr(os, value, context);
+        }
+        os << ']';
+    }
+
+    ObjectHolder& List::At(int index) {
+        const auto size = static_cast<long long>(values_.size());
+        const long long position = (index < 0) ? size + index : index;
+        if (position < 0 || position >= size)
+        {
+            throw std::runtime_error("List index out of range"s);
+        }
+        return values_[static_cast<size_t>(position)];
+    }
+
+    void List::Append(ObjectHolder value) {
+        if (values_.size() == values_.capacity())
+        {
+            // Память учитывается до роста, чтобы превышение ограничения не выделяло её
+            const size_t capacity = std::max<size_t>(values_.capacity() * 2, 4);
+            heap_charge_.Update(capacity * sizeof(ObjectHolder));
+            values_.reserve(capacity);
         }
+        values_.push_back(std::move(value));
+    }
 
+    ObjectHolder List::Call(const std::string& method, const std::vector<ObjectHolder>& actual_args) {
+        if (method == "append"sv && actual_args.size() == 1)
         {
-            auto lhs_ptr = lhs.TryAs<Number>();
-            auto rhs_ptr = rhs.TryAs<Number>();
-            if ((lhs_ptr != nullptr) && (rhs_ptr != nullptr))
+            Append(actual_args.front());
+            return ObjectHolder::None();
+        }
+        throw std::runtime_error("List has no method "s + method + " with "s
+            + std::to_string(actual_args.size()) + " arguments"s);
+    }
+
+    size_t List::Size() const {
+        return values_.size();
+    }
+
+    const std::vector<ObjectHolder>& List::Values() const {
+        return values_;
+    }
+
+    namespace {
+        const std::string HASH_METHOD = "__hash__"s;
+
+        // Перемешивает биты хеша (финализатор splitmix64), чтобы младшие 7 бит (H2)
+        // и старшие биты (номер группы) зависели от всего значения
+        size_t MixHash(std::uint64_t value) {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ULL;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebULL;
+            value ^= value >> 31;
+            return static_cast<size_t>(value);
+        }
+
+        size_t HashKey(const ObjectHolder& key, Context& context) {
+            if (!key)
+            {
+                return MixHash(0x9e3779b97f4a7c15ULL);
+            }
+            switch (key->GetType())
+            {
+            case ObjectType::Number:
+                return MixHash(static_cast<std::uint32_t>(static_cast<const Number&>(*key).GetValue()));
+            case ObjectType::String:
+                return MixHash(std::hash<std::string>{}(static_cast<const String&>(*key).GetValue()));
+            case ObjectType::Bool:
+                return MixHash(static_cast<const Bool&>(*key).GetValue() ? 0x2ULL : 0x3ULL);
+            case ObjectType::ClassInstance:
             {
-                return lhs_ptr->GetValue() == rhs_ptr->GetValue();
+                auto& instance = static_cast<ClassInstance&>(*key);
+                if (instance.HasMethod(HASH_METHOD, 0))
+                {
+                    auto hash = instance.Call(HASH_METHOD, {}, context);
+                    if (auto hash_ptr = hash.TryAs<Number>())
+                    {
+                        return MixHash(static_cast<std::uint32_t>(hash_ptr->GetValue()));
+                    }
+                    throw std::runtime_error("__hash__ must return a number"s);
+                }
+                if (!instance.HasMethod("__eq__"s, 1))
+                {
+                    return MixHash(reinterpret_cast<std::uintptr_t>(&instance));
+                }
+                break;
+            }
+            default:
+                break;
             }
+            throw std::runtime_error("Unhashable dict key"s);
         }
 
-        {
-            auto lhs_ptr = lhs.TryAs<String>();
-            auto rhs_ptr = rhs.TryAs<String>();
-            if ((lhs_ptr != nullptr) && (rhs_ptr != nullptr))
+        bool KeysEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+            if (lhs.Get() == rhs.Get())
+            {
+                return true;
+            }
+            if (!lhs || !rhs || lhs->GetType() != rhs->GetType())
+            {
+                return false;
+            }
+            if (lhs->GetType() == ObjectType::ClassInstance
+                && !lhs.TryAs<ClassInstance>()->HasMethod("__eq__"s, 1))
+            {
+                return false;
+            }
+            return Compare<CompareOp::Equal>(lhs, rhs, context);
+        }
+
+        // Загружает группу управляющих байтов в 64-битное слово, младший байт - первая ячейка
+        std::uint64_t LoadGroup(const std::uint8_t* ctrl) {
+            std::uint64_t group = 0;
+            for (size_t i = 0; i < 8; ++i)
             {
-                return lhs_ptr->GetValue() == rhs_ptr->GetValue();
+                group |= static_cast<std::uint64_t>(ctrl[i]) << (8 * i);
             }
+            return group;
         }
 
+        constexpr std::uint64_t LSBS = 0x0101010101010101ULL;
+        constexpr std::uint64_t MSBS = 0x8080808080808080ULL;
+
+        // Возвращает маску, в которой старший бит байта установлен для ячеек с управляющим байтом h2.
+        // Возможны ложные срабатывания, поэтому кандидаты проверяются по полному хешу
+        std::uint64_t MatchByte(std::uint64_t group, std::uint8_t h2) {
+            const std::uint64_t x = group ^ (LSBS * h2);
+            return (x - LSBS) & ~x & MSBS;
+        }
+
+        // Свободные ячейки - единственные, у которых установлен старший бит управляющего байта
+        std::uint64_t MatchEmpty(std::uint64_t group) {
+            return group & MSBS;
+        }
+
+        // Возвращает номер первой ячейки, отмеченной в маске, и снимает её отметку
+        size_t PopFirst(std::uint64_t& mask) {
+            size_t index = 0;
+#if defined(__GNUC__)
+            index = static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+#else
+            while ((mask & (0x80ULL << (8 * index))) == 0)
+            {
+                ++index;
+            }
+#endif
+            mask &= mask - 1;
+            return index;
+        }
+    }  // namespace
+
+    Dict::Dict() : Object(ObjectType::Dict) {
+    }
+
+    void Dict::Print(std::ostream& os, Context& context) {
+        os << '{';
+        bool first = true;
+        for (const auto& entry : entries_)
         {
-            auto lhs_ptr = lhs.TryAs<Bool>();
-            auto rhs_ptr = rhs.TryAs<Bool>();
-            if ((lhs_ptr != nullptr) && (rhs_ptr != nullptr))
+            if (!first)
             {
-                return lhs_ptr->GetValue() == rhs_ptr->GetValue();
+                os << ", "sv;
             }
+            first = false;
+            PrintRepr(os, entry.key, context);
+            os << ": "sv;
+            PrintRepr(os, entry.value, context);
         }
+        os << '}';
+    }
 
-        //  У lhs есть метод __eq__
+    size_t Dict::FindEntry(const ObjectHolder& key, size_t hash, Context& context) const {
+        if (ctrl_.empty())
         {
-            auto lhs_ptr = lhs.TryAs<ClassInstance>();
-            if (lhs_ptr != nullptr)
+            return NPOS;
+        }
+        const auto h2 = static_cast<std::uint8_t>(hash & 0x7F);
+        const size_t group_mask = ctrl_.size() / GROUP_WIDTH - 1;
+        size_t group_index = (hash >> 7) & group_mask;
+        // Треугольная последовательность проб обходит все группы, так как их число - степень двойки
+        for (size_t step = 1;; ++step)
+        {
+            const size_t base = group_index * GROUP_WIDTH;
+            const std::uint64_t group = LoadGroup(&ctrl_[base]);
+            for (std::uint64_t match = MatchByte(group, h2); match != 0;)
             {
-                if (lhs_ptr->HasMethod("__eq__"s, 1))
+                const std::uint32_t entry = slots_[base + PopFirst(match)];
+                if (entries_[entry].hash == hash && KeysEqual(entries_[entry].key, key, context))
                 {
-                    ObjectHolder result = lhs_ptr->Call("__eq__"s, { rhs }, context);
-                    return result.TryAs<Bool>()->GetValue();
+                    return entry;
                 }
             }
+            if (MatchEmpty(group) != 0)
+            {
+                return NPOS;
+            }
+            group_index = (group_index + step) & group_mask;
         }
-        throw std::runtime_error("Cannot compare objects for equality"s);
     }
 
-    bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    void Dict::PlaceEntry(size_t hash, std::uint32_t entry) {
+        const size_t group_mask = ctrl_.size() / GROUP_WIDTH - 1;
+        size_t group_index = (hash >> 7) & group_mask;
+        for (size_t step = 1;; ++step)
         {
-            auto lhs_ptr = lhs.TryAs<Number>();
-            auto rhs_ptr = rhs.TryAs<Number>();
-            if ((lhs_ptr != nullptr) && (rhs_ptr != nullptr))
+            const size_t base = group_index * GROUP_WIDTH;
+            std::uint64_t empty = MatchEmpty(LoadGroup(&ctrl_[base]));
+            if (empty != 0)
             {
-                return lhs_ptr->GetValue() < rhs_ptr->GetValue();
+                const size_t slot = base + PopFirst(empty);
+                ctrl_[slot] = static_cast<std::uint8_t>(hash & 0x7F);
+                slots_[slot] = entry;
+                return;
             }
+            group_index = (group_index + step) & group_mask;
         }
+    }
 
+    void Dict::Grow() {
+        const size_t capacity = ctrl_.empty() ? GROUP_WIDTH : ctrl_.size() * 2;
+        UpdateHeapCharge(capacity, entries_.capacity());
+        ctrl_.assign(capacity, EMPTY);
+        slots_.assign(capacity, 0);
+        for (size_t i = 0; i < entries_.size(); ++i)
         {
-            auto lhs_ptr = lhs.TryAs<String>();
-            auto rhs_ptr = rhs.TryAs<String>();
-            if ((lhs_ptr != nullptr) && (rhs_ptr != nullptr))
+            PlaceEntry(entries_[i].hash, static_cast<std::uint32_t>(i));
+        }
+    }
+
+    void Dict::UpdateHeapCharge(size_t table_capacity, size_t entry_capacity) {
+        heap_charge_.Update(table_capacity * (sizeof(std::uint8_t) + sizeof(std::uint32_t))
+                            + entry_capacity * sizeof(Entry));
+    }
+
+    ObjectHolder* Dict::Find(const ObjectHolder& key, Context& context) {
+        const size_t entry = FindEntry(key, HashKey(key, context), context);
+        return (entry == NPOS) ? nullptr : &entries_[entry].value;
+    }
+
+    void Dict::Insert(const ObjectHolder& key, ObjectHolder value, Context& context) {
+        const size_t hash = HashKey(key, context);
+        const size_t entry = FindEntry(key, hash, context);
+        if (entry != NPOS)
+        {
+            entries_[entry].value = std::move(value);
+            return;
+        }
+        // Заполненность таблицы не превышает 7/8, поэтому поиск всегда встречает свободную ячейку
+        if ((entries_.size() + 1) * 8 > ctrl_.size() * 7)
+        {
+            Grow();
+        }
+        if (entries_.size() == entries_.capacity())
+        {
+            const size_t entry_capacity = std::max<size_t>(entries_.capacity() * 2, 4);
+            UpdateHeapCharge(ctrl_.size(), entry_capacity);
+            entries_.reserve(entry_capacity);
+        }
+        entries_.push_back({ hash, key, std::move(value) });
+        PlaceEntry(hash, static_cast<std::uint32_t>(entries_.size() - 1));
+    }
+
+    ObjectHolder Dict::Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+        if (method == "get"sv && (actual_args.size() == 1 || actual_args.size() == 2))
+        {
+            if (ObjectHolder* value = Find(actual_args[0], context))
             {
-                return lhs_ptr->GetValue() < rhs_ptr->GetValue();
+                return *value;
             }
+            return (actual_args.size() == 2) ? actual_args[1] : ObjectHolder::None();
         }
-
+        if ((method == "keys"sv || method == "values"sv) && actual_args.empty())
         {
-            auto lhs_ptr = lhs.TryAs<Bool>();
-            auto rhs_ptr = rhs.TryAs<Bool>();
-            if ((lhs_ptr != nullptr) && (rhs_ptr != nullptr))
+            const bool keys = (method == "keys"sv);
+            std::vector<ObjectHolder> result;
+            result.reserve(entries_.size());
+            for (const auto& entry : entries_)
             {
-                return lhs_ptr->GetValue() < rhs_ptr->GetValue();
+                result.push_back(keys ? entry.key : entry.value);
             }
+            return ObjectHolder::Own(List{ std::move(result) });
         }
+        throw std::runtime_error("Dict has no method "s + method + " with "s
+            + std::to_string(actual_args.size()) + " arguments"s);
+    }
 
-        // У lhs есть метод __lt__
-        {
+    size_t Dict::Size() const {
+        return entries_.size();
+    }
+
+    const std::vector<Dict::Entry>& Dict::Entries() const {
+        return entries_;
+    }
+
+    void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
+        WriteText(os, GetValue() ? "True"sv : "False"sv);
+    }
+
+
+    namespace {
+        // Сравнивает значения встроенных типов операцией Op
+        template <CompareOp Op, typename T>
+        bool CompareValues(const T& lhs, const T& rhs) {
+            if constexpr (Op == CompareOp::Less) {
+                return lhs < rhs;
+            } else if constexpr (Op == CompareOp::Greater) {
+                return lhs > rhs;
+            } else if constexpr (Op == CompareOp::Equal) {
+                return lhs == rhs;
+            } else if constexpr (Op == CompareOp::NotEqual) {
+                return lhs != rhs;
+            } else if constexpr (Op == CompareOp::LessOrEqual) {
+                return lhs <= rhs;
+            } else {
+                return lhs >= rhs;
+            }
+        }
+
+        // Вызывает у lhs метод сравнения method с аргументом rhs.
+        // Если такого метода нет, выбрасывает runtime_error с сообщением error
+        bool CallCompareMethod(const ObjectHolder& lhs, const std::string& method, const ObjectHolder& rhs,
+            const std::string& error, Context& context) {
             auto lhs_ptr = lhs.TryAs<ClassInstance>();
-            if (lhs_ptr != nullptr)
+            if ((lhs_ptr != nullptr) && lhs_ptr->HasMethod(method, 1))
+            {
+                ObjectHolder result = lhs_ptr->Call(method, { rhs }, context);
+                return result.TryAs<Bool>()->GetValue();
+            }
+            throw std::runtime_error(error);
+        }
+
+        const std::string EQ_METHOD = "__eq__"s;
+        const std::string LT_METHOD = "__lt__"s;
+        const std::string EQ_ERROR = "Cannot compare objects for equality"s;
+        const std::string LT_ERROR = "Cannot compare objects for less"s;
+
+        // Сравнивает списки на равенство поэлементно
+        bool ListsEqual(const List& lhs, const List& rhs, Context& context) {
+            if (lhs.Size() != rhs.Size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < lhs.Size(); ++i)
             {
-                if (lhs_ptr->HasMethod("__lt__"s, 1))
+                if (!Compare<CompareOp::Equal>(lhs.Values()[i], rhs.Values()[i], context))
                 {
-                    ObjectHolder result = lhs_ptr->Call("__lt__"s, { rhs }, context);
-                    return result.TryAs<Bool>()->GetValue();
+                    return false;
                 }
             }
+            return true;
         }
-        throw std::runtime_error("Cannot compare objects for less"s);
+
+        // Сравнивает словари на равенство: одинаковые ключи с попарно равными значениями
+        bool DictsEqual(const Dict& lhs, Dict& rhs, Context& context) {
+            if (lhs.Size() != rhs.Size())
+            {
+                return false;
+            }
+            for (const auto& entry : lhs.Entries())
+            {
+                const ObjectHolder* value = rhs.Find(entry.key, context);
+                if (value == nullptr || !Compare<CompareOp::Equal>(entry.value, *value, context))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }  // namespace
+
+    template <CompareOp Op>
+    bool Compare(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        // Встроенные типы: тип каждого аргумента проверяется один раз
+        if (auto lhs_ptr = lhs.TryAs<Number>())
+        {
+            if (auto rhs_ptr = rhs.TryAs<Number>())
+            {
+                return CompareValues<Op>(lhs_ptr->GetValue(), rhs_ptr->GetValue());
+            }
+        }
+        else if (auto lhs_ptr = lhs.TryAs<String>())
+        {
+            if (auto rhs_ptr = rhs.TryAs<String>())
+            {
+                return CompareValues<Op>(lhs_ptr->GetValue(), rhs_ptr->GetValue());
+            }
+        }
+        else if (auto lhs_ptr = lhs.TryAs<Bool>())
+        {
+            if (auto rhs_ptr = rhs.TryAs<Bool>())
+            {
+                return CompareValues<Op>(lhs_ptr->GetValue(), rhs_ptr->GetValue());
+            }
+        }
+
+        constexpr bool is_equality = (Op == CompareOp::Equal) || (Op == CompareOp::NotEqual);
+
+        // lhs и rhs это None: равны, но не упорядочены
+        if (!lhs && !rhs)
+        {
+            if constexpr (is_equality) {
+                return Op == CompareOp::Equal;
+            } else {
+                throw std::runtime_error(LT_ERROR);
+            }
+        }
+
+        if constexpr (is_equality) {
+            auto lhs_list = lhs.TryAs<List>();
+            auto rhs_list = rhs.TryAs<List>();
+            if (lhs_list != nullptr && rhs_list != nullptr)
+            {
+                bool equal = ListsEqual(*lhs_list, *rhs_list, context);
+                return (Op == CompareOp::Equal) ? equal : !equal;
+            }
+            auto lhs_dict = lhs.TryAs<Dict>();
+            auto rhs_dict = rhs.TryAs<Dict>();
+            if (lhs_dict != nullptr && rhs_dict != nullptr)
+            {
+                bool equal = DictsEqual(*lhs_dict, *rhs_dict, context);
+                return (Op == CompareOp::Equal) ? equal : !equal;
+            }
+        }
+
+        // Пользовательские классы: lhs > rhs вычисляется как !(lhs < rhs || lhs == rhs),
+        // lhs <= rhs - как lhs < rhs || lhs == rhs
+        if constexpr (is_equality) {
+            bool equal = CallCompareMethod(lhs, EQ_METHOD, rhs, EQ_ERROR, context);
+            return (Op == CompareOp::Equal) ? equal : !equal;
+        } else if constexpr (Op == CompareOp::Less || Op == CompareOp::GreaterOrEqual) {
+            bool less = CallCompareMethod(lhs, LT_METHOD, rhs, LT_ERROR, context);
+            return (Op == CompareOp::Less) ? less : !less;
+        } else {
+            bool less_or_equal = CallCompareMethod(lhs, LT_METHOD, rhs, LT_ERROR, context)
+                || CallCompareMethod(lhs, EQ_METHOD, rhs, EQ_ERROR, context);
+            return (Op == CompareOp::LessOrEqual) ? less_or_equal : !less_or_equal;
+        }
+    }
+
+    template bool Compare<CompareOp::Less>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<CompareOp::Greater>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<CompareOp::Equal>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<CompareOp::NotEqual>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<CompareOp::LessOrEqual>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<CompareOp::GreaterOrEqual>(const ObjectHolder&, const ObjectHolder&, Context&);
+
+    bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<CompareOp::Equal>(lhs, rhs, context);
+    }
+
+    bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<CompareOp::Less>(lhs, rhs, context);
     }
 
     bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        return !Equal(lhs, rhs, context);
+        return Compare<CompareOp::NotEqual>(lhs, rhs, context);
     }
 
     bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        return !(Less(lhs, rhs, context) || Equal(lhs, rhs, context));
+        return Compare<CompareOp::Greater>(lhs, rhs, context);
     }
 
     bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        return Less(lhs, rhs, context) || Equal(lhs, rhs, context);
+        return Compare<CompareOp::LessOrEqual>(lhs, rhs, context);
     }
 
     bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        return !Less(lhs, rhs, context);
+        return Compare<CompareOp::GreaterOrEqual>(lhs, rhs, context);
     }
 
 }  // namespace runtime
\ No newline at end of file
@@ -1,29 +1,415 @@
 #pragma once
 
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <unordered_map>
 #include <vector>
 
 namespace runtime {
 
+    class Executable;
+    class Profiler;
+    class Statistics;
+    class RecordWriter;
+
+    // Статистика, в которой учитываются объекты, создаваемые в текущем потоке (см. statistics.h),
+    // или nullptr
+    inline thread_local Statistics* current_statistics = nullptr;
+
+    // Ошибка исполнения: программа превысила одно из ограничений выполнения (см. ExecutionLimits).
+    // После неё программу можно не доделывать, а интерпретатор остаётся пригодным к работе
+    class LimitError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Ошибка исполнения: превышена максимальная глубина вложенных вызовов методов
+    class RecursionError : public LimitError {
+    public:
+        using LimitError::LimitError;
+    };
+
+    // Ограничения выполнения программы. Нулевое значение снимает ограничение
+    struct ExecutionLimits {
+        // Число шагов выполнения: итераций циклов и вызовов методов и функций
+        uint64_t max_steps = 0;
+        // Объём ещё не удалённых объектов, созданных через ObjectHolder::Own, в байтах
+        size_t max_heap_bytes = 0;
+        // Время выполнения, отсчитываемое от вызова Context::SetLimits
+        std::chrono::steady_clock::duration timeout{};
+    };
+
+    // Учёт памяти объектов программы при ограничении max_heap_bytes. Объекты могут удаляться
+    // в других потоках и после завершения программы, поэтому учёт атомарный, а сам объект
+    // существует, пока существует хотя бы один учтённый в нём объект
+    class HeapAccount : public std::enable_shared_from_this<HeapAccount> {
+    public:
+        explicit HeapAccount(size_t limit)
+            : limit_(limit) {
+        }
+
+        // Учитывает выделение bytes байтов. Если ограничение будет превышено, выбрасывает LimitError
+        void Charge(size_t bytes);
+        void Release(size_t bytes) noexcept {
+            used_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t GetUsedBytes() const {
+            return used_bytes_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        const size_t limit_;
+        std::atomic<size_t> used_bytes_ = 0;
+    };
+
+    // Учёт памяти, в котором отмечаются объекты, создаваемые в текущем потоке (см. LimitScope),
+    // или nullptr
+    inline thread_local HeapAccount* current_heap_account = nullptr;
+
+    // Запас стека, который остаётся нетронутым при входе в метод и при вычислении вложенных
+    // выражений: его хватает на вычисление одного узла, выброс RecursionError и обработку ошибки
+    inline constexpr size_t STACK_RESERVE = 128 * 1024;
+
+    // Наименьший адрес стека текущего потока, ниже которого вызовы Mython и вычисление вложенных
+    // выражений не опускаются (с учётом STACK_RESERVE), или 0, если он ещё не определён.
+    // Определяется при первой проверке в потоке. Код, выполняющий программы на собственном
+    // стеке, задаёт его сам
+    inline thread_local uintptr_t current_stack_limit = 0;
+
+    // Возвращает границу стека текущего потока для current_stack_limit
+    uintptr_t FindThreadStackLimit();
+
+    // Возвращает true, если стека текущего потока осталось меньше STACK_RESERVE
+    inline bool IsStackExhausted() {
+        if (current_stack_limit == 0)
+        {
+            current_stack_limit = FindThreadStackLimit();
+        }
+        // Стек растёт вниз, поэтому адрес локальной переменной показывает, сколько его осталось
+        const char marker = 0;
+        return reinterpret_cast<uintptr_t>(&marker) < current_stack_limit;
+    }
+
+    [[noreturn]] void ThrowExpressionTooDeep();
+
+    // Выбрасывает RecursionError, если стека текущего потока осталось меньше STACK_RESERVE.
+    // Вызывается узлами, которые вычисляют вложенные выражения или инструкции: глубоко
+    // вложенное выражение без вызовов методов иначе переполнило бы стек
+    inline void CheckStack() {
+        if (IsStackExhausted())
+        {
+            ThrowExpressionTooDeep();
+        }
+    }
+
     // Контекст исполнения инструкций Mython
     class Context {
     public:
+        // Глубина вызовов по умолчанию. Независимо от неё вызов, которому не хватает стека,
+        // выбрасывает RecursionError (см. current_stack_limit)
+        static constexpr size_t DEFAULT_MAX_CALL_DEPTH = 5000;
+
         // Возвращает поток вывода для команд print
         virtual std::ostream& GetOutputStream() = 0;
 
+        // Возвращает и задаёт максимальную глубину вложенных вызовов методов Mython.
+        // Хвостовые вызовы (return obj.method(...)) глубину не увеличивают
+        [[nodiscard]] size_t GetMaxCallDepth() const {
+            return max_call_depth_;
+        }
+        void SetMaxCallDepth(size_t depth) {
+            max_call_depth_ = depth;
+        }
+
+        // Отмечают вход в метод и выход из него. При превышении максимальной глубины вызовов
+        // или если стека потока осталось меньше STACK_RESERVE, EnterCall выбрасывает RecursionError
+        void EnterCall();
+        void LeaveCall() {
+            --call_depth_;
+        }
+
+        // Задаёт ограничения выполнения и начинает их отсчёт заново: счётчик шагов обнуляется,
+        // время отсчитывается от текущего момента. Глубина вызовов ограничивается SetMaxCallDepth
+        void SetLimits(const ExecutionLimits& limits);
+        [[nodiscard]] const ExecutionLimits& GetLimits() const {
+            return limits_;
+        }
+
+        // Отмечает шаг выполнения: итерацию цикла или вызов. Обычно лишь уменьшает счётчик,
+        // а раз в несколько тысяч шагов проверяет ограничения и при их превышении
+        // выбрасывает LimitError
+        void Step() {
+            if (--fuel_ == 0)
+            {
+                Refuel();
+            }
+        }
+        [[nodiscard]] uint64_t GetStepCount() const {
+            return steps_ + (chunk_ - fuel_);
+        }
+
+        // Задаёт функцию, которую выполнение программы вызывает каждые slice_steps шагов, чтобы
+        // уступить поток другим программам (см. scheduler.h). Пустая функция отключает уступки
+        void SetYield(uint64_t slice_steps, std::function<void()> yield);
+
+        // Учёт памяти при ограничении max_heap_bytes или nullptr
+        [[nodiscard]] HeapAccount* GetHeapAccount() const {
+            return heap_.get();
+        }
+
+        // Профилировщик, в теневом стеке которого отмечаются вызовы методов и функций,
+        // или nullptr. Вызовы, начатые до подключения профилировщика, в стек не попадают
+        [[nodiscard]] Profiler* GetProfiler() const {
+            return profiler_;
+        }
+        void SetProfiler(Profiler* profiler) {
+            profiler_ = profiler;
+        }
+
+        // Статистика выполнения (см. statistics.h) или nullptr
+        [[nodiscard]] Statistics* GetStatistics() const {
+            return statistics_;
+        }
+        void SetStatistics(Statistics* statistics) {
+            statistics_ = statistics;
+        }
+
+        // Если задан, команды print записывают значения в двоичном формате (см. record_output.h),
+        // а не выводят их текстом
+        [[nodiscard]] RecordWriter* GetRecordWriter() const {
+            return record_writer_;
+        }
+        void SetRecordWriter(RecordWriter* record_writer) {
+            record_writer_ = record_writer;
+        }
+
+        // Вызывается при раскрутке стека: отмечает statement как инструкцию, при выполнении которой
+        // возникло текущее исключение. Для каждого исключения запоминается самая вложенная инструкция
+        void NoteFailedStatement(const Executable* statement) {
+            std::exception_ptr current = std::current_exception();
+            if (current != failed_exception_)
+            {
+                failed_exception_ = std::move(current);
+                failed_statement_ = statement;
+            }
+        }
+        // Возвращает инструкцию, при выполнении которой возникло исключение error, или nullptr
+        [[nodiscard]] const Executable* GetFailedStatement(const std::exception_ptr& error) const {
+            return error == failed_exception_ ? failed_statement_ : nullptr;
+        }
+
     protected:
         ~Context() = default;
+
+    private:
+        // Число шагов между проверками времени выполнения
+        static constexpr uint64_t STEP_CHECK_INTERVAL = 1024;
+
+        // Проверяет ограничения, при необходимости уступает поток и выдаёт следующую порцию шагов
+        void Refuel();
+        [[nodiscard]] uint64_t NextChunk() const;
+
+        size_t call_depth_ = 0;
+        size_t max_call_depth_ = DEFAULT_MAX_CALL_DEPTH;
+        Profiler* profiler_ = nullptr;
+        Statistics* statistics_ = nullptr;
+        RecordWriter* record_writer_ = nullptr;
+
+        ExecutionLimits limits_;
+        // Шаги, выполненные до текущей порции. В порции chunk_ шагов, из них осталось fuel_
+        uint64_t steps_ = 0;
+        uint64_t chunk_ = UINT64_MAX;
+        uint64_t fuel_ = UINT64_MAX;
+        std::chrono::steady_clock::time_point deadline_ = std::chrono::steady_clock::time_point::max();
+        std::shared_ptr<HeapAccount> heap_;
+        // Уступка потока: каждые yield_slice_ шагов, следующая - после шага next_yield_
+        std::function<void()> yield_;
+        uint64_t yield_slice_ = 0;
+        uint64_t next_yield_ = 0;
+
+        std::exception_ptr failed_exception_;
+        const Executable* failed_statement_ = nullptr;
+    };
+
+    // Тип объекта Mython. Позволяет распознавать встроенные типы без dynamic_cast
+    enum class ObjectType : unsigned char {
+        Other,
+        Number,
+        String,
+        Bool,
+        Class,
+        ClassInstance,
+        TailCall,
+        List,
+        Dict,
+        Function,
+    };
+
+    // Отмечает в statistics создание объекта типа type
+    void NoteAllocation(Statistics& statistics, ObjectType type);
+
+    // Пока существует, объекты, создаваемые в текущем потоке через ObjectHolder::Own,
+    // учитываются в ограничении памяти контекста context
+    class LimitScope {
+    public:
+        explicit LimitScope(const Context& context)
+            : previous_(current_heap_account) {
+            current_heap_account = context.GetHeapAccount();
+        }
+
+        LimitScope(const LimitScope&) = delete;
+        LimitScope& operator=(const LimitScope&) = delete;
+
+        ~LimitScope() {
+            current_heap_account = previous_;
+        }
+
+    private:
+        HeapAccount* previous_;
+    };
+
+    // Распределитель памяти, учитывающий выделенные байты и extra_bytes байтов содержимого объекта
+    // (например, символов строки) в HeapAccount
+    template <typename T>
+    class HeapAllocator {
+    public:
+        using value_type = T;
+
+        HeapAllocator(std::shared_ptr<HeapAccount> account, size_t extra_bytes)
+            : account_(std::move(account)), extra_bytes_(extra_bytes) {
+        }
+        template <typename U>
+        HeapAllocator(const HeapAllocator<U>& other)  // NOLINT(google-explicit-constructor)
+            : account_(other.account_), extra_bytes_(other.extra_bytes_) {
+        }
+
+        T* allocate(size_t n) {
+            account_->Charge(n * sizeof(T) + extra_bytes_);
+            return std::allocator<T>().allocate(n);
+        }
+        void deallocate(T* ptr, size_t n) noexcept {
+            std::allocator<T>().deallocate(ptr, n);
+            account_->Release(n * sizeof(T) + extra_bytes_);
+        }
+
+        template <typename U>
+        bool operator==(const HeapAllocator<U>& other) const {
+            return account_ == other.account_;
+        }
+        template <typename U>
+        bool operator!=(const HeapAllocator<U>& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        template <typename U>
+        friend class HeapAllocator;
+
+        std::shared_ptr<HeapAccount> account_;
+        size_t extra_bytes_;
+    };
+
+    /*
+     * Учёт в HeapAccount памяти, которую контейнер (список, словарь) выделяет по мере роста.
+     * Запоминает учёт памяти потока, действующий при создании контейнера, и освобождает
+     * учтённые байты при удалении контейнера
+     */
+    class HeapCharge {
+    public:
+        HeapCharge()
+            : account_(current_heap_account != nullptr ? current_heap_account->shared_from_this() : nullptr) {
+        }
+
+        HeapCharge(HeapCharge&& other) noexcept
+            : account_(std::move(other.account_)), bytes_(std::exchange(other.bytes_, 0)) {
+        }
+        HeapCharge& operator=(HeapCharge&& other) noexcept {
+            if (this != &other)
+            {
+                ReleaseAll();
+                account_ = std::move(other.account_);
+                bytes_ = std::exchange(other.bytes_, 0);
+            }
+            return *this;
+        }
+
+        HeapCharge(const HeapCharge&) = delete;
+        HeapCharge& operator=(const HeapCharge&) = delete;
+
+        ~HeapCharge() {
+            ReleaseAll();
+        }
+
+        // Приводит учтённый объём к bytes. Вызывается до выделения памяти: если ограничение
+        // будет превышено, выбрасывает LimitError, и контейнер не растёт
+        void Update(size_t bytes) {
+            if (account_ == nullptr)
+            {
+                return;
+            }
+            if (bytes > bytes_)
+            {
+                account_->Charge(bytes - bytes_);
+            }
+            else
+            {
+                account_->Release(bytes_ - bytes);
+            }
+            bytes_ = bytes;
+        }
+
+    private:
+        void ReleaseAll() noexcept {
+            if (account_ != nullptr)
+            {
+                account_->Release(bytes_);
+            }
+            bytes_ = 0;
+        }
+
+        std::shared_ptr<HeapAccount> account_;
+        size_t bytes_ = 0;
     };
 
+    // Размер содержимого объекта, хранящегося вне него самого. Уточняется для строк.
+    // Списки и словари растут после создания и учитывают своё содержимое сами (см. HeapCharge)
+    template <typename T>
+    size_t GetPayloadSize(const T& /*object*/) {
+        return 0;
+    }
+
     // Базовый класс для всех объектов языка Mython
     class Object {
     public:
         virtual ~Object() = default;
         // выводит в os своё представление в виде строки
         virtual void Print(std::ostream& os, Context& context) = 0;
+
+        // Возвращает тип объекта
+        [[nodiscard]] ObjectType GetType() const {
+            return type_;
+        }
+
+    protected:
+        explicit Object(ObjectType type = ObjectType::Other)
+            : type_(type) {
+        }
+
+    private:
+        ObjectType type_;
     };
 
     // Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе
@@ -37,7 +423,18 @@ namespace runtime {
         // object копируется или перемещается в кучу
         template <typename T>
         [[nodiscard]] static ObjectHolder Own(T&& object) {
-            return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+            std::shared_ptr<T> data;
+            if (current_heap_account == nullptr) {
+                data = std::make_shared<T>(std::forward<T>(object));
+            } else {
+                const size_t payload = GetPayloadSize(object);
+                data = std::allocate_shared<T>(
+                    HeapAllocator<T>(current_heap_account->shared_from_this(), payload), std::forward<T>(object));
+            }
+            if (current_statistics != nullptr) {
+                NoteAllocation(*current_statistics, data->GetType());
+            }
+            return ObjectHolder(std::move(data));
         }
 
         // Создаёт ObjectHolder, не владеющий объектом (аналог слабой ссылки)
@@ -45,6 +442,21 @@ namespace runtime {
         // Создаёт пустой ObjectHolder, соответствующий значению None
         [[nodiscard]] static ObjectHolder None();
 
+        // Возвращают ObjectHolder, ссылающиеся на единственные на процесс объекты True и False.
+        // Эти объекты никогда не удаляются, поэтому не требуют ни выделения памяти,
+        // ни подсчёта ссылок
+        [[nodiscard]] static ObjectHolder True();
+        [[nodiscard]] static ObjectHolder False();
+        [[nodiscard]] static ObjectHolder FromBool(bool value);
+
+        // Возвращает ObjectHolder с числом value. Небольшие числа (от SMALL_NUMBER_MIN
+        // до SMALL_NUMBER_MAX включительно) берутся из заранее созданного кэша без выделения памяти,
+        // остальные размещаются в куче, как при вызове Own
+        [[nodiscard]] static ObjectHolder FromNumber(int value);
+
+        static constexpr int SMALL_NUMBER_MIN = -256;
+        static constexpr int SMALL_NUMBER_MAX = 1024;
+
         // Возвращает ссылку на Object внутри ObjectHolder.
         // ObjectHolder должен быть непустым
         Object& operator*() const;
@@ -54,39 +466,80 @@ namespace runtime {
         [[nodiscard]] Object* Get() const;
 
         // Возвращает указатель на объект типа T либо nullptr, если внутри ObjectHolder не хранится
-        // объект данного типа
+        // объект данного типа. Встроенные типы распознаются по ObjectType, остальные - через dynamic_cast
         template <typename T>
-        [[nodiscard]] T* TryAs() const {
-            return dynamic_cast<T*>(this->Get());
-        }
+        [[nodiscard]] T* TryAs() const;
 
         // Возвращает true, если ObjectHolder не пуст
         explicit operator bool() const;
 
     private:
+        friend class ClassInstance;
+
         explicit ObjectHolder(std::shared_ptr<Object> data);
         void AssertIsValid() const;
 
         std::shared_ptr<Object> data_;
     };
 
+    // Наибольшая длина десятичной записи int со знаком
+    inline constexpr size_t MAX_NUMBER_TEXT_SIZE = std::numeric_limits<int>::digits10 + 2;
+
+    // Записывает десятичное представление value в buffer и возвращает его.
+    // В отличие от вывода в поток, не зависит от локали и не обращается к num_put
+    inline std::string_view FormatNumber(int value, char (&buffer)[MAX_NUMBER_TEXT_SIZE]) {
+        const auto result = std::to_chars(buffer, buffer + MAX_NUMBER_TEXT_SIZE, value);
+        return {buffer, static_cast<size_t>(result.ptr - buffer)};
+    }
+
+    // Выводят текст встроенных значений в буфер потока os без форматирования iostream.
+    // Ширина поля и флаги форматирования os не учитываются
+    inline void WriteText(std::ostream& os, std::string_view text) {
+        os.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    inline void WriteNumber(std::ostream& os, int value) {
+        char buffer[MAX_NUMBER_TEXT_SIZE];
+        WriteText(os, FormatNumber(value, buffer));
+    }
+
     // Объект-значение, хранящий значение типа T
     template <typename T>
     class ValueObject : public Object {
     public:
         ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-            : value_(v) {
+            : Object(TypeOfValue()), value_(v) {
         }
 
         void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
-            os << value_;
+            if constexpr (std::is_same_v<T, int>) {
+                WriteNumber(os, value_);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                WriteText(os, value_);
+            } else {
+                os << value_;
+            }
         }
 
         [[nodiscard]] const T& GetValue() const {
             return value_;
         }
 
+    protected:
+        ValueObject(T v, ObjectType type)
+            : Object(type), value_(v) {
+        }
+
     private:
+        static constexpr ObjectType TypeOfValue() {
+            if constexpr (std::is_same_v<T, int>) {
+                return ObjectType::Number;
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                return ObjectType::String;
+            } else {
+                return ObjectType::Other;
+            }
+        }
+
         T value_;
     };
 
@@ -94,7 +547,8 @@ namespace runtime {
     using Closure = std::unordered_map<std::string, ObjectHolder>;
 
     // Проверяет, содержится ли в object значение, приводимое к True
-    // Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
+    // Для отличных от нуля чисел, True, непустых строк, списков и словарей возвращается true.
+    // В остальных случаях - false.
     bool IsTrue(const ObjectHolder& object);
 
     // Интерфейс для выполнения действий над объектами Mython
@@ -103,7 +557,7 @@ namespace runtime {
         virtual ~Executable() = default;
         // Выполняет действие над объектами внутри closure, используя context
         // Возвращает результирующее значение либо None
-        virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
+        virtual ObjectHolder Execute(Closure& closure, Context& context) const = 0;
     };
 
     // Строковое значение
@@ -111,14 +565,29 @@ namespace runtime {
     // Числовое значение
     using Number = ValueObject<int>;
 
+    inline size_t GetPayloadSize(const String& str) {
+        return str.GetValue().capacity();
+    }
+
     // Логическое значение
     class Bool : public ValueObject<bool> {
     public:
-        using ValueObject<bool>::ValueObject;
+        Bool(bool v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+            : ValueObject<bool>(v, ObjectType::Bool) {
+        }
 
         void Print(std::ostream& os, Context& context) override;
     };
 
+    class ClassInstance;
+
+    // Реализация метода на C++. Получает объект self и аргументы вызова без создания Closure
+    using NativeMethod = std::function<ObjectHolder(ClassInstance& self,
+        const std::vector<ObjectHolder>& actual_args, Context& context)>;
+    // Реализация функции на C++. Получает аргументы вызова без создания Closure
+    using NativeFunction = std::function<ObjectHolder(const std::vector<ObjectHolder>& actual_args,
+        Context& context)>;
+
     // Метод класса
     struct Method {
         // Имя метода
@@ -127,8 +596,37 @@ namespace runtime {
         std::vector<std::string> formal_params;
         // Тело метода
         std::unique_ptr<Executable> body;
+        // Реализация метода на C++. Если задана, используется вместо body
+        NativeMethod native{};
+    };
+
+    // Функция, объявленная вне класса. Вызов функции разрешается на этапе разбора программы,
+    // поэтому она не требует ни экземпляра класса, ни поиска метода по имени
+    struct Function : public Object {
+        Function()
+            : Object(ObjectType::Function) {
+        }
+
+        // Выводит в os строку "Function <имя функции>"
+        void Print(std::ostream& os, Context& context) override;
+
+        // Имя функции
+        std::string name;
+        // Имена формальных параметров функции
+        std::vector<std::string> formal_params;
+        // Тело функции
+        std::unique_ptr<Executable> body;
+        // Реализация функции на C++. Если задана, используется вместо body
+        NativeFunction native;
     };
 
+    /*
+     * Вызывает функцию function, передавая ей actual_args параметров.
+     * Если число аргументов не совпадает с числом параметров, выбрасывает runtime_error
+     */
+    ObjectHolder CallFunction(const Function& function, const std::vector<ObjectHolder>& actual_args,
+        Context& context);
+
     // Класс
     class Class : public Object {
     public:
@@ -152,8 +650,9 @@ namespace runtime {
         std::unordered_map<std::string_view, const Method*> vtable_; // таблица виртуальных функций класса
     };
 
-    // Экземпляр класса
-    class ClassInstance : public Object {
+    // Экземпляр класса. Экземпляр, созданный через ObjectHolder::Own, передаёт своим методам
+    // владеющую ссылку self, поэтому сохранённый программой self не становится висячим
+    class ClassInstance : public Object, public std::enable_shared_from_this<ClassInstance> {
     public:
         explicit ClassInstance(const Class& cls);
 
@@ -181,15 +680,191 @@ namespace runtime {
         [[nodiscard]] const Closure& Fields() const;
 
     private:
-        
+        friend class TailCall;
+
+        // Выполняет тело метода method. Вместо результата может вернуть отложенный хвостовой вызов
+        ObjectHolder Invoke(const std::string& method, const std::vector<ObjectHolder>& actual_args,
+            Context& context);
+
         const Class& class_; // ссылка на класс
         Closure fields_; // поля экземпляра класса
     };
 
+    /*
+     * Функции и классы, реализованные на C++ встраивающим приложением. Передаются разборщику
+     * через ParseOptions::builtins и доступны программе Mython так же, как объявленные в ней самой.
+     * Объект Builtins должен существовать, пока используются разобранные с ним программы.
+     *
+     * Реестр может дополнять реестр parent: функции и классы parent видны через него, а
+     * регистрация имени, уже имеющегося в parent, выбрасывает runtime_error. Если parent пополнен
+     * позже и имя оказалось в обоих реестрах, используется определение из parent
+     */
+    class Builtins {
+    public:
+        explicit Builtins(const Builtins* parent = nullptr);
+
+        // Регистрирует функцию name с параметрами params, реализованную функцией native.
+        // Если функция с таким именем уже есть, выбрасывает runtime_error
+        const Function& AddFunction(std::string name, std::vector<std::string> params,
+            NativeFunction native);
+
+        // Регистрирует класс name с методами methods, унаследованный от класса parent.
+        // Методы могут быть реализованы на C++ (Method::native). Если класс с таким именем
+        // уже есть, выбрасывает runtime_error
+        const Class& AddClass(std::string name, std::vector<Method> methods, const Class* parent = nullptr);
+
+        // Возвращают функцию или класс с именем name либо nullptr
+        [[nodiscard]] Function* FindFunction(const std::string& name) const;
+        [[nodiscard]] Class* FindClass(const std::string& name) const;
+
+        // Возвращают функции и классы, зарегистрированные в самом реестре, без реестра parent
+        [[nodiscard]] const std::vector<std::unique_ptr<Function>>& GetFunctions() const;
+        [[nodiscard]] const std::vector<std::unique_ptr<Class>>& GetClasses() const;
+        // Возвращает дополняемый реестр или nullptr
+        [[nodiscard]] const Builtins* GetParent() const;
+
+    private:
+        const Builtins* parent_ = nullptr;
+        std::vector<std::unique_ptr<Function>> functions_;
+        std::vector<std::unique_ptr<Class>> classes_;
+    };
+
+    /*
+     * Отложенный хвостовой вызов object.method(args) или function(args).
+     * Тело метода или функции, последним действием которого является такой return, возвращает
+     * этот объект вместо результата, и ClassInstance::Call или CallFunction выполняет вызов в цикле,
+     * не увеличивая глубину стека C++ и глубину вызовов в Context
+     */
+    class TailCall : public Object {
+    public:
+        TailCall(ObjectHolder object, std::string method, std::vector<ObjectHolder> args);
+        TailCall(const Function& function, std::vector<ObjectHolder> args);
+
+        void Print(std::ostream& os, Context& context) override;
+
+        [[nodiscard]] const ObjectHolder& GetObject() const;
+        [[nodiscard]] const std::string& GetMethod() const;
+        // Возвращает вызываемую функцию либо nullptr для вызова метода
+        [[nodiscard]] const Function* GetFunction() const;
+        [[nodiscard]] std::vector<ObjectHolder>& GetArgs();
+
+        // Выполняет тело вызываемого метода или функции. Результатом снова может быть TailCall
+        ObjectHolder Invoke(Context& context);
+
+    private:
+        ObjectHolder object_;
+        std::string method_;
+        const Function* function_ = nullptr;
+        std::vector<ObjectHolder> args_;
+    };
+
+    /*
+     * Список. Элементы хранятся в непрерывном массиве, поэтому доступ по индексу выполняется за O(1),
+     * а добавление в конец - за амортизированное O(1)
+     */
+    class List : public Object {
+    public:
+        List();
+        explicit List(std::vector<ObjectHolder> values);
+
+        // Выводит элементы через запятую в квадратных скобках, строки - в одинарных кавычках,
+        // например [1, 'abc', None]
+        void Print(std::ostream& os, Context& context) override;
+
+        /*
+         * Возвращает ссылку на элемент с индексом index. Отрицательный индекс отсчитывается
+         * от конца списка, как в Python. При выходе за границы списка выбрасывает runtime_error
+         */
+        [[nodiscard]] ObjectHolder& At(int index);
+
+        // Добавляет value в конец списка
+        void Append(ObjectHolder value);
+
+        /*
+         * Вызывает метод списка method с аргументами actual_args. Поддерживается метод append(value),
+         * возвращающий None. Для остальных методов выбрасывает runtime_error
+         */
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args);
+
+        [[nodiscard]] size_t Size() const;
+        [[nodiscard]] const std::vector<ObjectHolder>& Values() const;
+
+    private:
+        std::vector<ObjectHolder> values_;
+        HeapCharge heap_charge_;
+    };
+
+    /*
+     * Словарь с открытой адресацией в стиле Swiss table.
+     *
+     * Записи (хеш, ключ, значение) хранятся в плотном массиве entries_ в порядке добавления.
+     * Хеш-таблица состоит из массива управляющих байтов ctrl_ и массива slots_ с номерами записей.
+     * Управляющий байт свободной ячейки равен EMPTY, занятой - младшим 7 битам хеша ключа (H2).
+     * Поиск просматривает ячейки группами по GROUP_WIDTH байтов: кандидаты внутри группы
+     * находятся одной операцией над 64-битным словом, а ключи сравниваются, только если совпали
+     * H2 и полный хеш. Хеши ключей хранятся в записях и при росте таблицы не пересчитываются.
+     *
+     * Ключами могут быть None, числа, строки, значения Bool и экземпляры классов.
+     * Экземпляр класса с методом __hash__ хешируется результатом этого метода и сравнивается методом
+     * __eq__; экземпляр без методов __hash__ и __eq__ хешируется и сравнивается по адресу.
+     * Для остальных ключей выбрасывается runtime_error
+     */
+    class Dict : public Object {
+    public:
+        struct Entry {
+            size_t hash;
+            ObjectHolder key;
+            ObjectHolder value;
+        };
+
+        Dict();
+
+        // Выводит пары в фигурных скобках в порядке добавления, например {1: 'a', 'b': None}
+        void Print(std::ostream& os, Context& context) override;
+
+        // Возвращает указатель на значение, соответствующее key, либо nullptr, если ключа нет
+        [[nodiscard]] ObjectHolder* Find(const ObjectHolder& key, Context& context);
+
+        // Связывает key со значением value, добавляя ключ при необходимости
+        void Insert(const ObjectHolder& key, ObjectHolder value, Context& context);
+
+        /*
+         * Вызывает метод словаря method с аргументами actual_args. Поддерживаются методы
+         * get(key[, default]), keys() и values(), последние два возвращают List.
+         * Для остальных методов выбрасывает runtime_error
+         */
+        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
+            Context& context);
+
+        [[nodiscard]] size_t Size() const;
+        [[nodiscard]] const std::vector<Entry>& Entries() const;
+
+    private:
+        static constexpr size_t GROUP_WIDTH = 8;
+        static constexpr std::uint8_t EMPTY = 0x80;
+        static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+        // Возвращает номер записи с ключом key и хешем hash либо NPOS
+        size_t FindEntry(const ObjectHolder& key, size_t hash, Context& context) const;
+        // Помещает номер записи entry в первую свободную ячейку на пути поиска hash
+        void PlaceEntry(size_t hash, std::uint32_t entry);
+        // Увеличивает таблицу вдвое, используя сохранённые хеши
+        void Grow();
+        // Учитывает память таблицы из table_capacity ячеек и массива записей ёмкости entry_capacity
+        void UpdateHeapCharge(size_t table_capacity, size_t entry_capacity);
+
+        std::vector<std::uint8_t> ctrl_;
+        std::vector<std::uint32_t> slots_;
+        std::vector<Entry> entries_;
+        HeapCharge heap_charge_;
+    };
+
     /*
      * Возвращает true, если lhs и rhs содержат одинаковые числа, строки или значения типа Bool.
      * Если lhs - объект с методом __eq__, функция возвращает результат вызова lhs.__eq__(rhs),
      * приведённый к типу Bool. Если lhs и rhs имеют значение None, функция возвращает true.
+     * Списки равны, если имеют одинаковую длину и попарно равные элементы.
+     * Словари равны, если содержат одинаковые ключи с равными значениями.
      * В остальных случаях функция выбрасывает исключение runtime_error.
      *
      * Параметр context задаёт контекст для выполнения метода __eq__
@@ -214,6 +889,54 @@ namespace runtime {
     // Возвращает значение, противоположное Less(lhs, rhs, context)
     bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 
+    // Операции сравнения
+    enum class CompareOp {
+        Less,
+        Greater,
+        Equal,
+        NotEqual,
+        LessOrEqual,
+        GreaterOrEqual,
+    };
+
+    /*
+     * Сравнивает lhs и rhs операцией Op. Результат совпадает с результатом соответствующей функции
+     * Less, Greater, Equal, NotEqual, LessOrEqual или GreaterOrEqual, но для чисел, строк и значений
+     * Bool типы аргументов определяются однократно, а сравнение выполняется за один проход.
+     * Для объектов пользовательских классов вызываются методы __lt__ и __eq__ по тем же правилам
+     */
+    template <CompareOp Op>
+    bool Compare(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    template <typename T>
+    T* ObjectHolder::TryAs() const {
+        auto cast_if = [this](ObjectType type) -> T* {
+            Object* object = Get();
+            return (object != nullptr && object->GetType() == type) ? static_cast<T*>(object) : nullptr;
+        };
+        if constexpr (std::is_same_v<T, Number>) {
+            return cast_if(ObjectType::Number);
+        } else if constexpr (std::is_same_v<T, String>) {
+            return cast_if(ObjectType::String);
+        } else if constexpr (std::is_same_v<T, Bool>) {
+            return cast_if(ObjectType::Bool);
+        } else if constexpr (std::is_same_v<T, Class>) {
+            return cast_if(ObjectType::Class);
+        } else if constexpr (std::is_same_v<T, ClassInstance>) {
+            return cast_if(ObjectType::ClassInstance);
+        } else if constexpr (std::is_same_v<T, TailCall>) {
+            return cast_if(ObjectType::TailCall);
+        } else if constexpr (std::is_same_v<T, List>) {
+            return cast_if(ObjectType::List);
+        } else if constexpr (std::is_same_v<T, Dict>) {
+            return cast_if(ObjectType::Dict);
+        } else if constexpr (std::is_same_v<T, Function>) {
+            return cast_if(ObjectType::Function);
+        } else {
+            return dynamic_cast<T*>(Get());
+        }
+    }
+
     // Контекст-заглушка, применяется в тестах.
     // В этом контексте весь вывод перенаправляется в строковый поток вывода output
     struct DummyContext : Context {
@@ -2,6 +2,7 @@
 #include "test_runner.h"
 
 #include <functional>
+#include <limits>
 
 using namespace std;
 
@@ -19,7 +20,8 @@ public:
     }
 
     Logger(const Logger& rhs)
-        : id_(rhs.id_)  //
+        : Object(rhs)
+        , id_(rhs.id_)  //
     {
         ++instance_count;
     }
@@ -60,6 +62,13 @@ void TestNumber() {
     num.Print(context.output, context);
     ASSERT_EQUAL(context.output.str(), "127"s);
     ASSERT_EQUAL(num.GetValue(), 127);
+
+    // Числа выводятся без форматирования потока, в том числе крайние значения int
+    for (const int value : {0, -5, numeric_limits<int>::max(), numeric_limits<int>::min()}) {
+        DummyContext value_context;
+        Number(value).Print(value_context.output, value_context);
+        ASSERT_EQUAL(value_context.output.str(), to_string(value));
+    }
 }
 
 void TestString() {
@@ -98,7 +107,7 @@ struct TestMethodBody : Executable {
         : body(std::move(body)) {
     }
 
-    ObjectHolder Execute(Closure& closure, Context& context) override {
+    ObjectHolder Execute(Closure& closure, Context& context) const override {
         if (body) {
             return body(closure, context);
         }
@@ -242,6 +251,31 @@ void TestMove() {
     }
 }
 
+void TestInternedValues() {
+    ASSERT(ObjectHolder::True().Get() == ObjectHolder::FromBool(true).Get());
+    ASSERT(ObjectHolder::False().Get() == ObjectHolder::FromBool(false).Get());
+    ASSERT(ObjectHolder::True().Get() != ObjectHolder::False().Get());
+    ASSERT(IsTrue(ObjectHolder::True()));
+    ASSERT(!IsTrue(ObjectHolder::False()));
+
+    // Небольшие числа берутся из кэша
+    for (int value : {ObjectHolder::SMALL_NUMBER_MIN, -1, 0, 1, 42, ObjectHolder::SMALL_NUMBER_MAX}) {
+        auto number = ObjectHolder::FromNumber(value);
+        ASSERT(number.Get() == ObjectHolder::FromNumber(value).Get());
+        ASSERT_EQUAL(number.TryAs<Number>()->GetValue(), value);
+    }
+
+    // Большие числа размещаются в куче
+    auto big = ObjectHolder::FromNumber(ObjectHolder::SMALL_NUMBER_MAX + 1);
+    ASSERT(big.Get() != ObjectHolder::FromNumber(ObjectHolder::SMALL_NUMBER_MAX + 1).Get());
+    ASSERT_EQUAL(big.TryAs<Number>()->GetValue(), ObjectHolder::SMALL_NUMBER_MAX + 1);
+
+    DummyContext context;
+    ObjectHolder::True()->Print(context.output, context);
+    ObjectHolder::FromNumber(-7)->Print(context.output, context);
+    ASSERT_EQUAL(context.output.str(), "True-7"s);
+}
+
 void TestNullptr() {
     ObjectHolder oh;
     ASSERT(!oh);
@@ -282,6 +316,140 @@ void TestIsTrue() {
     }
 }
 
+void TestObjectTypes() {
+    Class cls{"Test"s, {}, nullptr};
+    ASSERT(ObjectHolder::Own(Number{1})->GetType() == ObjectType::Number);
+    ASSERT(ObjectHolder::Own(String{"1"s})->GetType() == ObjectType::String);
+    ASSERT(ObjectHolder::Own(Bool{true})->GetType() == ObjectType::Bool);
+    ASSERT(ObjectHolder::Share(cls)->GetType() == ObjectType::Class);
+    ASSERT(ObjectHolder::Own(ClassInstance{cls})->GetType() == ObjectType::ClassInstance);
+    ASSERT(ObjectHolder::Own(Logger{})->GetType() == ObjectType::Other);
+
+    ASSERT(ObjectHolder::Own(Number{1}).TryAs<String>() == nullptr);
+    ASSERT(ObjectHolder::Own(Bool{true}).TryAs<ValueObject<bool>>() != nullptr);
+    ASSERT(ObjectHolder::Own(Logger{}).TryAs<Logger>() != nullptr);
+    ASSERT(ObjectHolder::None().TryAs<Number>() == nullptr);
+}
+
+void TestList() {
+    DummyContext context;
+    List list;
+    ASSERT(!IsTrue(ObjectHolder::Share(list)));
+
+    list.Append(ObjectHolder::Own(Number{1}));
+    list.Append(ObjectHolder::Own(String{"a"s}));
+    ASSERT(!list.Call("append"s, {ObjectHolder::None()}));
+    ASSERT_EQUAL(list.Size(), 3U);
+    ASSERT(IsTrue(ObjectHolder::Share(list)));
+
+    ASSERT_EQUAL(list.At(0).TryAs<Number>()->GetValue(), 1);
+    ASSERT_EQUAL(list.At(-2).TryAs<String>()->GetValue(), "a"s);
+    ASSERT(!list.At(2));
+    ASSERT_THROWS((void)list.At(3), std::runtime_error);
+    ASSERT_THROWS((void)list.At(-4), std::runtime_error);
+    ASSERT_THROWS(list.Call("pop"s, {}), std::runtime_error);
+
+    list.At(-1) = ObjectHolder::Own(List{{ObjectHolder::True()}});
+    list.Print(context.output, context);
+    ASSERT_EQUAL(context.output.str(), "[1, 'a', [True]]"s);
+
+    auto make_list = [](std::vector<int> values) {
+        List result;
+        for (int value : values) {
+            result.Append(ObjectHolder::Own(Number{value}));
+        }
+        return ObjectHolder::Own(std::move(result));
+    };
+    ASSERT(Equal(make_list({1, 2}), make_list({1, 2}), context));
+    ASSERT(NotEqual(make_list({1, 2}), make_list({1, 3}), context));
+    ASSERT(NotEqual(make_list({1, 2}), make_list({1}), context));
+    ASSERT_THROWS(Less(make_list({1}), make_list({2}), context), std::runtime_error);
+}
+
+void TestDict() {
+    DummyContext context;
+    Dict dict;
+    ASSERT(!IsTrue(ObjectHolder::Share(dict)));
+
+    // Достаточно ключей, чтобы таблица несколько раз выросла
+    const int count = 5000;
+    for (int i = 0; i < count; ++i) {
+        dict.Insert(ObjectHolder::Own(Number{i}), ObjectHolder::Own(Number{i * 2}), context);
+        dict.Insert(ObjectHolder::Own(String{std::to_string(i)}), ObjectHolder::Own(Number{-i}),
+                    context);
+    }
+    ASSERT_EQUAL(dict.Size(), static_cast<size_t>(2 * count));
+    ASSERT(IsTrue(ObjectHolder::Share(dict)));
+    for (int i = 0; i < count; ++i) {
+        ASSERT_EQUAL(dict.Find(ObjectHolder::Own(Number{i}), context)->TryAs<Number>()->GetValue(),
+                     i * 2);
+        ASSERT_EQUAL(
+            dict.Find(ObjectHolder::Own(String{std::to_string(i)}), context)->TryAs<Number>()->GetValue(),
+            -i);
+    }
+    ASSERT(dict.Find(ObjectHolder::Own(Number{count}), context) == nullptr);
+    ASSERT(dict.Find(ObjectHolder::Own(Bool{true}), context) == nullptr);
+    ASSERT(dict.Find(ObjectHolder::None(), context) == nullptr);
+
+    // Повторная вставка заменяет значение, не меняя порядок записей
+    dict.Insert(ObjectHolder::Own(Number{0}), ObjectHolder::None(), context);
+    ASSERT_EQUAL(dict.Size(), static_cast<size_t>(2 * count));
+    ASSERT(!dict.Entries().front().value);
+    ASSERT_EQUAL(dict.Entries().back().key.TryAs<String>()->GetValue(), std::to_string(count - 1));
+
+    ASSERT_THROWS(dict.Insert(ObjectHolder::Own(List{}), ObjectHolder::None(), context),
+                  std::runtime_error);
+    ASSERT_THROWS(dict.Call("pop"s, {}, context), std::runtime_error);
+
+    Dict small;
+    small.Insert(ObjectHolder::Own(String{"a"s}), ObjectHolder::Own(Number{1}), context);
+    small.Insert(ObjectHolder::None(), ObjectHolder::Own(String{"b"s}), context);
+    small.Print(context.output, context);
+    ASSERT_EQUAL(context.output.str(), "{'a': 1, None: 'b'}"s);
+}
+
+void TestDictInstanceKeys() {
+    DummyContext context;
+
+    // Экземпляры без __hash__ и __eq__ сравниваются по адресу
+    Class plain{"Plain"s, {}, nullptr};
+    auto first = ObjectHolder::Own(ClassInstance{plain});
+    auto second = ObjectHolder::Own(ClassInstance{plain});
+    Dict dict;
+    dict.Insert(first, ObjectHolder::Own(Number{1}), context);
+    ASSERT(dict.Find(first, context) != nullptr);
+    ASSERT(dict.Find(second, context) == nullptr);
+
+    // Экземпляры с __hash__ и __eq__ сравниваются по значению поля value
+    vector<Method> methods;
+    methods.push_back({"__hash__"s, {}, make_unique<TestMethodBody>([](Closure& closure, Context&) {
+                           return closure.at("self"s).TryAs<ClassInstance>()->Fields().at("value"s);
+                       })});
+    methods.push_back({"__eq__"s, {"rhs"s}, make_unique<TestMethodBody>([](Closure& closure, Context& ctx) {
+                           auto& lhs = closure.at("self"s).TryAs<ClassInstance>()->Fields();
+                           auto& rhs = closure.at("rhs"s).TryAs<ClassInstance>()->Fields();
+                           return ObjectHolder::FromBool(Equal(lhs.at("value"s), rhs.at("value"s), ctx));
+                       })});
+    Class hashable{"Hashable"s, std::move(methods), nullptr};
+    auto make_key = [&hashable](int value) {
+        auto key = ObjectHolder::Own(ClassInstance{hashable});
+        key.TryAs<ClassInstance>()->Fields()["value"s] = ObjectHolder::Own(Number{value});
+        return key;
+    };
+    dict.Insert(make_key(7), ObjectHolder::Own(Number{2}), context);
+    ASSERT_EQUAL(dict.Find(make_key(7), context)->TryAs<Number>()->GetValue(), 2);
+    ASSERT(dict.Find(make_key(8), context) == nullptr);
+
+    // __eq__ без __hash__ делает экземпляр непригодным для ключа
+    vector<Method> eq_only;
+    eq_only.push_back({"__eq__"s, {"rhs"s}, make_unique<TestMethodBody>([](Closure&, Context&) {
+                           return ObjectHolder::True();
+                       })});
+    Class unhashable{"Unhashable"s, std::move(eq_only), nullptr};
+    ASSERT_THROWS(dict.Insert(ObjectHolder::Own(ClassInstance{unhashable}), ObjectHolder::None(), context),
+                  std::runtime_error);
+}
+
 void TestComparison() {
     auto test_equal = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool equality_result) {
         DummyContext ctx;
@@ -474,6 +642,48 @@ void TestComparison() {
     }
 }
 
+void TestCompareCallsEachMethodOnce() {
+    int eq_calls = 0;
+    int lt_calls = 0;
+    bool lt_result = false;
+    std::vector<Method> methods;
+    methods.push_back({"__eq__"s, {"rhs"s}, std::make_unique<TestMethodBody>([&eq_calls](Closure&, Context&) {
+                           ++eq_calls;
+                           return ObjectHolder::Own(Bool{false});
+                       })});
+    methods.push_back({"__lt__"s, {"rhs"s}, std::make_unique<TestMethodBody>([&lt_calls, &lt_result](Closure&, Context&) {
+                           ++lt_calls;
+                           return ObjectHolder::Own(Bool{lt_result});
+                       })});
+    Class cls{"Cls"s, std::move(methods), nullptr};
+    ClassInstance lhs{cls};
+    ClassInstance rhs{cls};
+    DummyContext ctx;
+
+    auto check_calls = [&](auto compare, bool less, bool expected, int expected_eq, int expected_lt) {
+        eq_calls = lt_calls = 0;
+        lt_result = less;
+        ASSERT_EQUAL(compare(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), ctx), expected);
+        ASSERT_EQUAL(eq_calls, expected_eq);
+        ASSERT_EQUAL(lt_calls, expected_lt);
+    };
+
+    check_calls(Compare<CompareOp::Less>, true, true, 0, 1);
+    check_calls(Compare<CompareOp::GreaterOrEqual>, true, false, 0, 1);
+    check_calls(Compare<CompareOp::Equal>, true, false, 1, 0);
+    check_calls(Compare<CompareOp::NotEqual>, true, true, 1, 0);
+    // __eq__ не вызывается, если результат определён вызовом __lt__
+    check_calls(Compare<CompareOp::Greater>, true, false, 0, 1);
+    check_calls(Compare<CompareOp::LessOrEqual>, true, true, 0, 1);
+    check_calls(Compare<CompareOp::Greater>, false, true, 1, 1);
+    check_calls(Compare<CompareOp::LessOrEqual>, false, false, 1, 1);
+
+    ASSERT(Compare<CompareOp::LessOrEqual>(ObjectHolder::Own(Number{2}), ObjectHolder::Own(Number{2}), ctx));
+    ASSERT(Compare<CompareOp::Greater>(ObjectHolder::Own(String{"b"s}), ObjectHolder::Own(String{"a"s}), ctx));
+    ASSERT(Compare<CompareOp::NotEqual>(ObjectHolder::Own(Bool{true}), ObjectHolder::Own(Bool{false}), ctx));
+    ASSERT_THROWS(Compare<CompareOp::GreaterOrEqual>(ObjectHolder::None(), ObjectHolder::None(), ctx), runtime_error);
+}
+
 void TestClass() {
     vector<Method> methods;
     Closure* passed_closure = nullptr;
@@ -537,7 +747,12 @@ void RunObjectsTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestBool);
     RUN_TEST(tr, runtime::TestMethodInvocation);
     RUN_TEST(tr, runtime::TestIsTrue);
+    RUN_TEST(tr, runtime::TestObjectTypes);
+    RUN_TEST(tr, runtime::TestList);
+    RUN_TEST(tr, runtime::TestDict);
+    RUN_TEST(tr, runtime::TestDictInstanceKeys);
     RUN_TEST(tr, runtime::TestComparison);
+    RUN_TEST(tr, runtime::TestCompareCallsEachMethodOnce);
     RUN_TEST(tr, runtime::TestClass);
     RUN_TEST(tr, runtime::TestClassInstance);
 }
@@ -547,6 +762,7 @@ void RunObjectHolderTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestOwning);
     RUN_TEST(tr, runtime::TestMove);
     RUN_TEST(tr, runtime::TestNullptr);
+    RUN_TEST(tr, runtime::TestInternedValues);
 }
 
 }  // namespace runtime
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "scheduler.h"
+
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Наименьший размер стека программы: кроме запаса runtime::STACK_RESERVE в нём должно
+// оставаться место для вызовов
+constexpr size_t MIN_STACK_SIZE = 2 * runtime::STACK_RESERVE;
+
+/*
+ * Программа, выполняющаяся на собственном стеке. Resume выполняет её до следующей уступки
+ * или до завершения. Уступка происходит внутри Context::Step, когда ни одна инструкция
+ * Mython не выполняется в обработчике исключения, поэтому состояние исключений потока
+ * у чередующихся программ не смешивается
+ */
+class Fiber {
+public:
+    Fiber(const ProgramTask& task, ProgramResult& result, const SchedulerOptions& options)
+        : task_(task)
+        , result_(result)
+        , limits_(options.limits)
+        , closure_(task.globals) {
+        context_.SetMaxCallDepth(options.max_call_depth);
+        context_.SetYield(options.slice_steps, [this] {
+            Yield();
+        });
+
+        const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t stack_size = (max(options.stack_size, MIN_STACK_SIZE) + page_size - 1) / page_size * page_size;
+        mapped_size_ = stack_size + page_size;
+        stack_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                      -1, 0);
+        if (stack_ == MAP_FAILED) {
+            throw runtime_error("Cannot allocate program stack"s);
+        }
+        // Нижняя страница защищена, чтобы переполнение стека не портило чужую память
+        mprotect(stack_, page_size, PROT_NONE);
+
+        getcontext(&fiber_context_);
+        fiber_context_.uc_stack.ss_sp = static_cast<char*>(stack_) + page_size;
+        // Вызов, которому не хватило бы стека программы, выбрасывает RecursionError (см. Context::EnterCall)
+        stack_limit_ = reinterpret_cast<uintptr_t>(fiber_context_.uc_stack.ss_sp) + runtime::STACK_RESERVE;
+        fiber_context_.uc_stack.ss_size = stack_size;
+        fiber_context_.uc_link = &return_context_;
+        makecontext(&fiber_context_, &Fiber::Entry, 0);
+    }
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    ~Fiber() {
+        munmap(stack_, mapped_size_);
+    }
+
+    void Resume() {
+        runtime::HeapAccount* const saved_account = runtime::current_heap_account;
+        const uintptr_t saved_stack_limit = runtime::current_stack_limit;
+        runtime::current_heap_account = context_.GetHeapAccount();
+        runtime::current_stack_limit = stack_limit_;
+        running_fiber = this;
+
+        const auto start = chrono::steady_clock::now();
+        swapcontext(&return_context_, &fiber_context_);
+        result_.duration += chrono::steady_clock::now() - start;
+
+        running_fiber = nullptr;
+        runtime::current_stack_limit = saved_stack_limit;
+        runtime::current_heap_account = saved_account;
+    }
+
+    [[nodiscard]] bool IsFinished() const {
+        return finished_;
+    }
+
+private:
+    static void Entry() {
+        running_fiber->Run();
+    }
+
+    void Run() noexcept {
+        context_.SetLimits(limits_);
+        runtime::current_heap_account = context_.GetHeapAccount();
+        try {
+            task_.program->Execute(closure_, context_);
+        } catch (const exception& e) {
+            result_.error = task_.source_map != nullptr ? parse::DescribeCurrentError(e, context_, *task_.source_map)
+                                                        : e.what();
+        } catch (...) {
+            result_.error = "Unknown error"s;
+        }
+        result_.output = output_.str();
+        finished_ = true;
+        // Возврат из Run передаёт управление в return_context_ через uc_link
+    }
+
+    void Yield() {
+        swapcontext(&fiber_context_, &return_context_);
+    }
+
+    static thread_local Fiber* running_fiber;
+
+    const ProgramTask& task_;
+    ProgramResult& result_;
+    runtime::ExecutionLimits limits_;
+    ostringstream output_;
+    runtime::SimpleContext context_{output_};
+    runtime::Closure closure_;
+
+    void* stack_ = nullptr;
+    size_t mapped_size_ = 0;
+    uintptr_t stack_limit_ = 0;
+    ucontext_t fiber_context_{};
+    ucontext_t return_context_{};
+    bool finished_ = false;
+};
+
+thread_local Fiber* Fiber::running_fiber = nullptr;
+
+// Поток выполняет свои программы по кругу. Начало очередного задания чередуется с продолжением
+// начатых программ, пока их меньше max_programs_per_thread
+void RunWorker(const vector<ProgramTask>& tasks, vector<ProgramResult>& results, const SchedulerOptions& options,
+               atomic<size_t>& next_task) {
+    const size_t max_fibers = max<size_t>(options.max_programs_per_thread, 1);
+    deque<unique_ptr<Fiber>> ready;
+    bool start_next = true;
+    while (true) {
+        unique_ptr<Fiber> fiber;
+        if (ready.size() < max_fibers && (start_next || ready.empty())) {
+            const size_t index = next_task.load() < tasks.size() ? next_task.fetch_add(1) : tasks.size();
+            if (index < tasks.size()) {
+                try {
+                    fiber = make_unique<Fiber>(tasks[index], results[index], options);
+                } catch (const exception& e) {
+                    results[index].error = e.what();
+                    continue;
+                }
+            }
+        }
+        if (!fiber) {
+            if (ready.empty()) {
+                return;
+            }
+            fiber = std::move(ready.front());
+            ready.pop_front();
+        }
+        start_next = !start_next;
+
+        fiber->Resume();
+        if (!fiber->IsFinished()) {
+            ready.push_back(std::move(fiber));
+        }
+    }
+}
+
+}  // namespace
+
+vector<ProgramResult> RunProgramsPreemptive(const vector<ProgramTask>& tasks, const SchedulerOptions& options) {
+    vector<ProgramResult> results(tasks.size());
+    atomic<size_t> next_task = 0;
+
+    vector<thread> workers;
+    const size_t thread_count = clamp<size_t>(options.threads, 1, max<size_t>(tasks.size(), 1));
+    for (size_t i = 1; i < thread_count; ++i) {
+        workers.emplace_back([&] {
+            RunWorker(tasks, results, options, next_task);
+        });
+    }
+    RunWorker(tasks, results, options, next_task);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
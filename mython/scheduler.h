@@ -0,0 +1,41 @@
+#pragma once
+
+#include "program_runner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Параметры вытесняющего выполнения программ
+struct SchedulerOptions {
+    // Число потоков, между которыми распределяются программы
+    size_t threads = 1;
+    // Число шагов (вызовов и итераций циклов), после которых программа уступает поток
+    uint64_t slice_steps = 1000;
+    // Наибольшее число начатых и не завершённых программ в одном потоке. Каждая из них
+    // занимает свой стек, поэтому память не растёт с числом заданий
+    size_t max_programs_per_thread = 16;
+    // Размер стека каждой программы в байтах (не меньше 2 * runtime::STACK_RESERVE).
+    // Вызов, которому не хватает стека, выбрасывает RecursionError, даже если глубина
+    // вызовов меньше max_call_depth
+    size_t stack_size = size_t{1} << 20;
+    size_t max_call_depth = runtime::Context::DEFAULT_MAX_CALL_DEPTH;
+    runtime::ExecutionLimits limits;
+};
+
+/*
+ * Выполняет задания tasks, чередуя их в потоках: каждая программа выполняется на своём
+ * стеке и после slice_steps шагов уступает поток следующей программе этого потока.
+ * Поэтому длинные программы не задерживают короткие, а бесконечный цикл не занимает
+ * поток целиком. Программа выполняется в том потоке, где начала выполняться: интерпретатор
+ * хранит часть состояния в thread_local переменных. Поток чередует продолжение начатых
+ * программ с началом следующего задания, пока у него меньше max_programs_per_thread
+ * начатых программ, поэтому начатые программы не ждут, пока закончатся задания.
+ *
+ * Результаты возвращаются в порядке заданий. duration — суммарное время, в течение которого
+ * программа выполнялась, без ожидания своей очереди. Ограничение времени из limits,
+ * напротив, отсчитывается от начала выполнения программы, включая ожидание. Профилировщик
+ * и статистика при таком выполнении не поддерживаются
+ */
+std::vector<ProgramResult> RunProgramsPreemptive(const std::vector<ProgramTask>& tasks,
+                                                 const SchedulerOptions& options);
@@ -0,0 +1,22 @@
+#include "source_map.h"
+
+using namespace std;
+
+namespace parse {
+
+    const SourceSpan* FindCurrentErrorSpan(const runtime::Context& context, const SourceMap& source_map) {
+        const runtime::Executable* statement = context.GetFailedStatement(current_exception());
+        return statement != nullptr ? source_map.Find(statement) : nullptr;
+    }
+
+    string DescribeCurrentError(const exception& error, const runtime::Context& context,
+                                const SourceMap& source_map) {
+        const SourceSpan* span = FindCurrentErrorSpan(context, source_map);
+        if (span == nullptr)
+        {
+            return error.what();
+        }
+        return DescribePosition(span->begin) + ": "s + error.what();
+    }
+
+}  // namespace parse
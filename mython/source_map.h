@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lexer.h"
+#include "runtime.h"
+
+#include <exception>
+#include <string>
+#include <unordered_map>
+
+namespace parse {
+
+    /*
+     * Участки исходного текста узлов синтаксического дерева. Хранятся отдельно от узлов,
+     * чтобы не увеличивать их размер: позиции нужны только для сообщений об ошибках и отчётов.
+     * Заполняется парсером, если карта передана в ParseOptions::source_map
+     */
+    class SourceMap {
+    public:
+        void Set(const runtime::Executable* node, const SourceSpan& span) {
+            spans_[node] = span;
+        }
+
+        // Возвращает участок текста узла node или nullptr, если он неизвестен
+        [[nodiscard]] const SourceSpan* Find(const runtime::Executable* node) const {
+            const auto it = spans_.find(node);
+            return it == spans_.end() ? nullptr : &it->second;
+        }
+
+        [[nodiscard]] size_t GetSize() const {
+            return spans_.size();
+        }
+
+    private:
+        std::unordered_map<const runtime::Executable*, SourceSpan> spans_;
+    };
+
+    // Вызывается в обработчике исключения, выброшенного при выполнении программы в контексте context.
+    // Возвращает участок текста инструкции, при выполнении которой оно возникло, или nullptr
+    const SourceSpan* FindCurrentErrorSpan(const runtime::Context& context, const SourceMap& source_map);
+
+    // Вызывается в обработчике исключения error, выброшенного при выполнении программы в контексте
+    // context. Возвращает текст ошибки, дополненный позицией инструкции, при выполнении которой
+    // она возникла, либо просто error.what(), если позиция неизвестна
+    std::string DescribeCurrentError(const std::exception& error, const runtime::Context& context,
+                                     const SourceMap& source_map);
+
+}  // namespace parse
@@ -1,5 +1,9 @@
 #include "statement.h"
 
+#include "record_output.h"
+#include "statistics.h"
+
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
@@ -14,15 +18,30 @@ namespace ast {
     namespace {
         const string ADD_METHOD = "__add__"s;
         const string INIT_METHOD = "__init__"s;
+
+        // Возвращает ссылку на элемент списка object[index]
+        ObjectHolder& ListElement(const ObjectHolder& object, const ObjectHolder& index) {
+            auto list_ptr = object.TryAs<runtime::List>();
+            if (list_ptr == nullptr)
+            {
+                throw std::runtime_error("Only lists and dicts support indexing"s);
+            }
+            auto index_ptr = index.TryAs<runtime::Number>();
+            if (index_ptr == nullptr)
+            {
+                throw std::runtime_error("List index must be a number"s);
+            }
+            return list_ptr->At(index_ptr->GetValue());
+        }
     }  // namespace
   
 
-    ObjectHolder Assignment::Execute(Closure& closure,[[maybe_unused]] Context& context) {
+    ObjectHolder Assignment::Execute(Closure& closure,[[maybe_unused]] Context& context) const {
         closure[var_] = std::move(rv_->Execute(closure, context));
         return closure.at(var_);
     }
 
-    ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context& context) {
+    ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context& context) const {
         if (dotted_ids_.size() > 0)
         {
             runtime::ObjectHolder result;
@@ -52,13 +71,25 @@ namespace ast {
 
    
 
-    ObjectHolder Print::Execute(Closure& closure, Context& context) {
+    ObjectHolder Print::Execute(Closure& closure, Context& context) const {
+        if (runtime::RecordWriter* record_writer = context.GetRecordWriter())
+        {
+            std::vector<runtime::ObjectHolder> values;
+            values.reserve(args_.size());
+            for (const auto& arg : args_)
+            {
+                values.push_back(arg->Execute(closure, context));
+            }
+            record_writer->Write(values, context);
+            return runtime::ObjectHolder::None();
+        }
+
         for (size_t i = 0; i < args_.size(); ++i)
         {
             // если  не первый элемент, нужно вывести разделяющий пробел
             if (i > 0)
             {
-                context.GetOutputStream() << " "s;
+                context.GetOutputStream().put(' ');
             }
 
             runtime::ObjectHolder result = args_[i]->Execute(closure, context);
@@ -70,7 +101,7 @@ namespace ast {
             }
             else
             {
-                context.GetOutputStream() << "None"s;
+                runtime::WriteText(context.GetOutputStream(), "None"sv);
             }
         }
         //перевод строки в конце вывода
@@ -78,14 +109,19 @@ namespace ast {
         return runtime::ObjectHolder::None();
     }
 
-    ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
+    ObjectHolder MethodCall::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         //если указателя ytт нет, возвращаем None()
         if (!object_)
         {
             return runtime::ObjectHolder::None();
         }
 
-        runtime::ObjectHolder callable_object = object_->Execute(closure, context);
+        return CallOn(object_->Execute(closure, context), closure, context);
+    }
+
+    ObjectHolder MethodCall::CallOn(const runtime::ObjectHolder& callable_object, Closure& closure,
+                                    Context& context) const {
         auto callable_object_ptr = callable_object.TryAs<runtime::ClassInstance>();
         if (callable_object_ptr != nullptr)
         {
@@ -97,10 +133,31 @@ namespace ast {
             runtime::ObjectHolder result = callable_object_ptr->Call(method_, args_values, context);
             return result;
         }
+        if (auto list_ptr = callable_object.TryAs<runtime::List>())
+        {
+            std::vector<runtime::ObjectHolder> args_values;
+            args_values.reserve(args_.size());
+            for (const auto& arg : args_)
+            {
+                args_values.push_back(arg->Execute(closure, context));
+            }
+            return list_ptr->Call(method_, args_values);
+        }
+        if (auto dict_ptr = callable_object.TryAs<runtime::Dict>())
+        {
+            std::vector<runtime::ObjectHolder> args_values;
+            args_values.reserve(args_.size());
+            for (const auto& arg : args_)
+            {
+                args_values.push_back(arg->Execute(closure, context));
+            }
+            return dict_ptr->Call(method_, args_values, context);
+        }
         return runtime::ObjectHolder::None();
     }
 
-    ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
+    ObjectHolder Stringify::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if (!argument_)
         {
             return runtime::ObjectHolder::Own(runtime::String{ "None"s });
@@ -110,12 +167,24 @@ namespace ast {
         {
             return runtime::ObjectHolder::Own(runtime::String{ "None"s });
         }
-        runtime::DummyContext dummy_context;
-        exec_result.Get()->Print(dummy_context.GetOutputStream(), dummy_context);
-        return runtime::ObjectHolder::Own(runtime::String{ dummy_context.output.str() });
+        // Числа и логические значения преобразуются без потока вывода
+        if (const auto* number = exec_result.TryAs<runtime::Number>())
+        {
+            char buffer[runtime::MAX_NUMBER_TEXT_SIZE];
+            return runtime::ObjectHolder::Own(runtime::String{ std::string(runtime::FormatNumber(number->GetValue(), buffer)) });
+        }
+        if (const auto* boolean = exec_result.TryAs<runtime::Bool>())
+        {
+            return runtime::ObjectHolder::Own(runtime::String{ boolean->GetValue() ? "True"s : "False"s });
+        }
+        // Метод __str__ исполняется в текущем контексте, чтобы учитывалась глубина вызовов
+        std::ostringstream output;
+        exec_result.Get()->Print(output, context);
+        return runtime::ObjectHolder::Own(runtime::String{ output.str() });
     }
 
-    ObjectHolder Add::Execute(Closure& closure, Context& context) {
+    ObjectHolder Add::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("No argument(s) specified for Add::Execute()"s);
@@ -131,7 +200,7 @@ namespace ast {
                 auto lhs_value = lhs_value_ptr->GetValue();
                 auto rhs_value = rhs_value_ptr->GetValue();
 
-                return runtime::ObjectHolder::Own(runtime::Number{ lhs_value + rhs_value });
+                return runtime::ObjectHolder::FromNumber(lhs_value + rhs_value);
             }
         }
         {
@@ -158,7 +227,8 @@ namespace ast {
         throw std::runtime_error("Incompatible argument(s) type(s) for Add::Execute()"s);
     }
 
-    ObjectHolder Sub::Execute(Closure& closure, Context& context) {
+    ObjectHolder Sub::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("No argument(s) specified for Sub::Execute()"s);
@@ -174,7 +244,7 @@ namespace ast {
                 auto lhs_value = lhs_value_ptr->GetValue();
                 auto rhs_value = rhs_value_ptr->GetValue();
 
-                return runtime::ObjectHolder::Own(runtime::Number{ lhs_value - rhs_value });
+                return runtime::ObjectHolder::FromNumber(lhs_value - rhs_value);
             }
 
         }
@@ -182,7 +252,8 @@ namespace ast {
         throw std::runtime_error("Incompatible argument(s) type(s) for Sub::Execute()"s);
     }
 
-    ObjectHolder Mult::Execute(Closure& closure, Context& context) {
+    ObjectHolder Mult::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("No argument(s) specified for Mult::Execute()"s);
@@ -198,14 +269,15 @@ namespace ast {
                 auto lhs_value = lhs_value_ptr->GetValue();
                 auto rhs_value = rhs_value_ptr->GetValue();
 
-                return runtime::ObjectHolder::Own(runtime::Number{ lhs_value * rhs_value });
+                return runtime::ObjectHolder::FromNumber(lhs_value * rhs_value);
             }
 
         }
         throw std::runtime_error("Incompatible argument(s) type(s) for Mult::Execute()"s);
     }
 
-    ObjectHolder Div::Execute(Closure& closure, Context& context) {
+    ObjectHolder Div::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("No argument(s) specified for Div::Execute()"s);
@@ -224,7 +296,7 @@ namespace ast {
                 {
                     throw std::runtime_error("Division by zero in Div::Execute()"s);
                 }
-                return runtime::ObjectHolder::Own(runtime::Number{ lhs_value / rhs_value });
+                return runtime::ObjectHolder::FromNumber(lhs_value / rhs_value);
             }
 
         }
@@ -236,15 +308,25 @@ namespace ast {
         statements_.push_back(std::move(stmt));
     }
 
-    ObjectHolder Compound::Execute(Closure& closure, Context& context) {
+    ObjectHolder Compound::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         for (const auto& statement : statements_)
         {
-            statement->Execute(closure, context);
+            try
+            {
+                statement->Execute(closure, context);
+            }
+            catch (const std::runtime_error&)
+            {
+                // Return, break и continue реализованы исключениями, не наследующими runtime_error
+                context.NoteFailedStatement(statement.get());
+                throw;
+            }
         }
         return runtime::ObjectHolder::None();
     }
 
-    ObjectHolder Return::Execute(Closure& closure, Context& context) {
+    ObjectHolder Return::Execute(Closure& closure, Context& context) const {
         if (!statement_)
         {
             throw ReturnException(runtime::ObjectHolder::None());
@@ -253,13 +335,61 @@ namespace ast {
         throw ReturnException(result);
     }
 
-    ObjectHolder ClassDefinition::Execute(Closure& closure,[[maybe_unused]] Context& context) {
+    ObjectHolder FunctionCall::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        std::vector<runtime::ObjectHolder> args_values;
+        args_values.reserve(args_.size());
+        for (const auto& arg : args_)
+        {
+            args_values.push_back(arg->Execute(closure, context));
+        }
+        return runtime::CallFunction(function_, args_values, context);
+    }
+
+    ObjectHolder FunctionDefinition::Execute(Closure& closure, [[maybe_unused]] Context& context) const {
+        closure[function_->name] = runtime::ObjectHolder::Share(*function_);
+        return runtime::ObjectHolder::None();
+    }
+
+    ObjectHolder TailReturn::Execute(Closure& closure, Context& context) const {
+        if (function_call_)
+        {
+            std::vector<runtime::ObjectHolder> args_values;
+            args_values.reserve(function_call_->args_.size());
+            for (const auto& arg : function_call_->args_)
+            {
+                args_values.push_back(arg->Execute(closure, context));
+            }
+            throw ReturnException(runtime::ObjectHolder::Own(
+                runtime::TailCall(function_call_->function_, std::move(args_values))));
+        }
+        if (!call_->object_)
+        {
+            throw ReturnException(runtime::ObjectHolder::None());
+        }
+        runtime::ObjectHolder callable_object = call_->object_->Execute(closure, context);
+        if (callable_object.TryAs<runtime::ClassInstance>() == nullptr)
+        {
+            // Методы списков и словарей не растят стек вызовов Mython, поэтому вызываются сразу
+            throw ReturnException(call_->CallOn(callable_object, closure, context));
+        }
+        std::vector<runtime::ObjectHolder> args_values;
+        args_values.reserve(call_->args_.size());
+        for (const auto& arg : call_->args_)
+        {
+            args_values.push_back(arg->Execute(closure, context));
+        }
+        throw ReturnException(runtime::ObjectHolder::Own(
+            runtime::TailCall(std::move(callable_object), call_->method_, std::move(args_values))));
+    }
+
+    ObjectHolder ClassDefinition::Execute(Closure& closure,[[maybe_unused]] Context& context) const {
         auto class_ptr = cls_.TryAs<runtime::Class>();
-        closure[class_ptr->GetName()] = std::move(cls_);
+        closure[class_ptr->GetName()] = cls_;
         return runtime::ObjectHolder::None();
     }
 
-    ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
+    ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) const {
         runtime::ObjectHolder object_value = object_.Execute(closure, context);
         if (!object_value)
         {
@@ -267,10 +397,125 @@ namespace ast {
         }
         auto object_value_ptr = object_value.TryAs<runtime::ClassInstance>();
         object_value_ptr->Fields()[field_name_] = std::move(rv_->Execute(closure, context));
+        if (runtime::Statistics* statistics = context.GetStatistics())
+        {
+            statistics->NoteFieldCount(object_value_ptr->Fields().size());
+        }
         return object_value_ptr->Fields().at(field_name_);
     }
 
-    ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
+    ObjectHolder ListLiteral::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        std::vector<runtime::ObjectHolder> values;
+        values.reserve(elements_.size());
+        for (const auto& element : elements_)
+        {
+            values.push_back(element->Execute(closure, context));
+        }
+        return runtime::ObjectHolder::Own(runtime::List{ std::move(values) });
+    }
+
+    ObjectHolder Index::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        if ((!lhs_) || (!rhs_))
+        {
+            throw std::runtime_error("Null operands specified for Index::Execute()"s);
+        }
+        runtime::ObjectHolder object = lhs_->Execute(closure, context);
+        runtime::ObjectHolder index = rhs_->Execute(closure, context);
+        if (auto dict_ptr = object.TryAs<runtime::Dict>())
+        {
+            if (runtime::ObjectHolder* value = dict_ptr->Find(index, context))
+            {
+                return *value;
+            }
+            throw std::runtime_error("Key not found in dict"s);
+        }
+        return ListElement(object, index);
+    }
+
+    ObjectHolder Contains::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        if ((!lhs_) || (!rhs_))
+        {
+            throw std::runtime_error("Null operands specified for Contains::Execute()"s);
+        }
+        runtime::ObjectHolder item = lhs_->Execute(closure, context);
+        runtime::ObjectHolder container = rhs_->Execute(closure, context);
+        if (auto dict_ptr = container.TryAs<runtime::Dict>())
+        {
+            return runtime::ObjectHolder::FromBool(dict_ptr->Find(item, context) != nullptr);
+        }
+        if (auto list_ptr = container.TryAs<runtime::List>())
+        {
+            for (const auto& value : list_ptr->Values())
+            {
+                if (runtime::Compare<runtime::CompareOp::Equal>(item, value, context))
+                {
+                    return runtime::ObjectHolder::True();
+                }
+            }
+            return runtime::ObjectHolder::False();
+        }
+        auto str_ptr = container.TryAs<runtime::String>();
+        auto substr_ptr = item.TryAs<runtime::String>();
+        if (str_ptr != nullptr && substr_ptr != nullptr)
+        {
+            return runtime::ObjectHolder::FromBool(
+                str_ptr->GetValue().find(substr_ptr->GetValue()) != std::string::npos);
+        }
+        throw std::runtime_error("Incompatible argument(s) type(s) for Contains::Execute()"s);
+    }
+
+    ObjectHolder DictLiteral::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        runtime::Dict dict;
+        for (const auto& [key, value] : items_)
+        {
+            runtime::ObjectHolder key_value = key->Execute(closure, context);
+            dict.Insert(key_value, value->Execute(closure, context), context);
+        }
+        return runtime::ObjectHolder::Own(std::move(dict));
+    }
+
+    ObjectHolder IndexAssignment::Execute(Closure& closure, Context& context) const {
+        // Как и в Python, присваиваемое значение вычисляется раньше списка и индекса
+        runtime::ObjectHolder value = rv_->Execute(closure, context);
+        runtime::ObjectHolder object = object_->Execute(closure, context);
+        runtime::ObjectHolder index = index_->Execute(closure, context);
+        if (auto dict_ptr = object.TryAs<runtime::Dict>())
+        {
+            dict_ptr->Insert(index, value, context);
+            return value;
+        }
+        ListElement(object, index) = value;
+        return value;
+    }
+
+    ObjectHolder Len::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        if (!argument_)
+        {
+            throw std::runtime_error("Null operand specified for Len::Execute()"s);
+        }
+        runtime::ObjectHolder arg_exec_result = argument_->Execute(closure, context);
+        if (auto list_ptr = arg_exec_result.TryAs<runtime::List>())
+        {
+            return runtime::ObjectHolder::FromNumber(static_cast<int>(list_ptr->Size()));
+        }
+        if (auto dict_ptr = arg_exec_result.TryAs<runtime::Dict>())
+        {
+            return runtime::ObjectHolder::FromNumber(static_cast<int>(dict_ptr->Size()));
+        }
+        if (auto str_ptr = arg_exec_result.TryAs<runtime::String>())
+        {
+            return runtime::ObjectHolder::FromNumber(static_cast<int>(str_ptr->GetValue().size()));
+        }
+        throw std::runtime_error("Incompatible argument type for Len::Execute()"s);
+    }
+
+    ObjectHolder IfElse::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if (!condition_)
         {
             throw std::runtime_error("No condition specified for IfElse::Execute()"s);
@@ -288,7 +533,99 @@ namespace ast {
         return runtime::ObjectHolder::None();
     }
 
-    ObjectHolder Or::Execute(Closure& closure, Context& context) {
+    ObjectHolder While::Execute(Closure& closure, Context& context) const {
+        if (!condition_)
+        {
+            throw std::runtime_error("No condition specified for While::Execute()"s);
+        }
+        while (runtime::IsTrue(condition_->Execute(closure, context)))
+        {
+            context.Step();
+            try
+            {
+                body_->Execute(closure, context);
+            }
+            catch (BreakException&)
+            {
+                break;
+            }
+            catch (ContinueException&)
+            {
+            }
+        }
+        return runtime::ObjectHolder::None();
+    }
+
+    namespace {
+        int EvaluateRangeArgument(Statement& argument, Closure& closure, Context& context) {
+            auto value = argument.Execute(closure, context);
+            auto value_ptr = value.TryAs<runtime::Number>();
+            if (value_ptr == nullptr)
+            {
+                throw std::runtime_error("range() arguments must be numbers"s);
+            }
+            return value_ptr->GetValue();
+        }
+    }  // namespace
+
+    ObjectHolder For::Execute(Closure& closure, Context& context) const {
+        if ((!start_) || (!stop_))
+        {
+            throw std::runtime_error("No range specified for For::Execute()"s);
+        }
+        const long long start = EvaluateRangeArgument(*start_, closure, context);
+        const long long stop = EvaluateRangeArgument(*stop_, closure, context);
+        const long long step = step_ ? EvaluateRangeArgument(*step_, closure, context) : 1;
+        if (step == 0)
+        {
+            throw std::runtime_error("range() step must not be zero"s);
+        }
+
+        // Ссылка на элемент unordered_map остаётся действительной при добавлении других переменных,
+        // поэтому переменная цикла ищется в closure один раз
+        runtime::ObjectHolder* var_slot = use_var_ ? &closure[var_] : nullptr;
+        bool executed = false;
+        // Значение текущей итерации: после break переменная должна хранить именно его
+        long long last = start;
+        for (long long value = start; (step > 0) ? (value < stop) : (value > stop); value += step)
+        {
+            executed = true;
+            last = value;
+            if (var_slot != nullptr)
+            {
+                *var_slot = runtime::ObjectHolder::FromNumber(static_cast<int>(value));
+            }
+            context.Step();
+            try
+            {
+                body_->Execute(closure, context);
+            }
+            catch (BreakException&)
+            {
+                break;
+            }
+            catch (ContinueException&)
+            {
+            }
+        }
+        if (executed && var_slot == nullptr)
+        {
+            // Как и в Python, после цикла переменная хранит последнее присвоенное значение
+            closure[var_] = runtime::ObjectHolder::FromNumber(static_cast<int>(last));
+        }
+        return runtime::ObjectHolder::None();
+    }
+
+    ObjectHolder Break::Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) const {
+        throw BreakException();
+    }
+
+    ObjectHolder Continue::Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) const {
+        throw ContinueException();
+    }
+
+    ObjectHolder Or::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("Null operands specified for Or::Execute()"s);
@@ -296,41 +633,59 @@ namespace ast {
         runtime::ObjectHolder lhs_exec_result = lhs_->Execute(closure, context);
         if (runtime::IsTrue(lhs_exec_result))
         {
-            return runtime::ObjectHolder::Own(runtime::Bool{ true });
+            return runtime::ObjectHolder::True();
         }
         runtime::ObjectHolder rhs_exec_result = rhs_->Execute(closure, context);
         if (runtime::IsTrue(rhs_exec_result))
         {
-            return runtime::ObjectHolder::Own(runtime::Bool{ true });
+            return runtime::ObjectHolder::True();
         }
-        return runtime::ObjectHolder::Own(runtime::Bool{ false });
+        return runtime::ObjectHolder::False();
     }
 
-    ObjectHolder And::Execute(Closure& closure, Context& context) {
+    ObjectHolder And::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("Null operands specified for And::Execute()"s);
         }
         runtime::ObjectHolder lhs_exec_result = lhs_->Execute(closure, context);
-        runtime::ObjectHolder rhs_exec_result = rhs_->Execute(closure, context);
-        if (runtime::IsTrue(lhs_exec_result) && runtime::IsTrue(rhs_exec_result))
+        if (!runtime::IsTrue(lhs_exec_result))
         {
-            return runtime::ObjectHolder::Own(runtime::Bool{ true });
+            return runtime::ObjectHolder::False();
         }
-        return runtime::ObjectHolder::Own(runtime::Bool{ false });
+        runtime::ObjectHolder rhs_exec_result = rhs_->Execute(closure, context);
+        return runtime::ObjectHolder::FromBool(runtime::IsTrue(rhs_exec_result));
     }
 
-    ObjectHolder Not::Execute(Closure& closure, Context& context) {
+    ObjectHolder Not::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if (!argument_)
         {
             throw std::runtime_error("Null operand specified for Not::Execute()"s);
         }
         runtime::ObjectHolder arg_exec_result = argument_->Execute(closure, context);
         bool result = runtime::IsTrue(arg_exec_result);
-        return runtime::ObjectHolder::Own(runtime::Bool{ !result });
+        return runtime::ObjectHolder::FromBool(!result);
+    }
+
+    ObjectHolder Negate::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        if (!argument_)
+        {
+            throw std::runtime_error("Null operand specified for Negate::Execute()"s);
+        }
+        runtime::ObjectHolder arg_exec_result = argument_->Execute(closure, context);
+        auto arg_value_ptr = arg_exec_result.TryAs<runtime::Number>();
+        if (arg_value_ptr != nullptr)
+        {
+            return runtime::ObjectHolder::FromNumber(-arg_value_ptr->GetValue());
+        }
+        throw std::runtime_error("Incompatible argument type for Negate::Execute()"s);
     }
 
-    ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
+    ObjectHolder Comparison::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
         if ((!lhs_) || (!rhs_))
         {
             throw std::runtime_error("Null operands specified for Comparison::Execute()"s);
@@ -338,24 +693,47 @@ namespace ast {
         runtime::ObjectHolder lhs_exec_result = lhs_->Execute(closure, context);
         runtime::ObjectHolder rhs_exec_result = rhs_->Execute(closure, context);
         bool result = cmp_(lhs_exec_result, rhs_exec_result, context);
-        return runtime::ObjectHolder::Own(runtime::Bool{ result });
+        return runtime::ObjectHolder::FromBool(result);
+    }
+
+    template <runtime::CompareOp Op>
+    ObjectHolder CompareOperation<Op>::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        if ((!lhs_) || (!rhs_))
+        {
+            throw std::runtime_error("Null operands specified for CompareOperation::Execute()"s);
+        }
+        runtime::ObjectHolder lhs_exec_result = lhs_->Execute(closure, context);
+        runtime::ObjectHolder rhs_exec_result = rhs_->Execute(closure, context);
+        bool result = runtime::Compare<Op>(lhs_exec_result, rhs_exec_result, context);
+        return runtime::ObjectHolder::FromBool(result);
     }
 
-    ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
-        if (class_instance_.HasMethod(INIT_METHOD, args_.size()))
+    template class CompareOperation<runtime::CompareOp::Less>;
+    template class CompareOperation<runtime::CompareOp::Greater>;
+    template class CompareOperation<runtime::CompareOp::Equal>;
+    template class CompareOperation<runtime::CompareOp::NotEqual>;
+    template class CompareOperation<runtime::CompareOp::LessOrEqual>;
+    template class CompareOperation<runtime::CompareOp::GreaterOrEqual>;
+
+    ObjectHolder NewInstance::Execute(Closure& closure, Context& context) const {
+        runtime::CheckStack();
+        runtime::ObjectHolder instance = runtime::ObjectHolder::Own(runtime::ClassInstance{ class_ });
+        auto instance_ptr = instance.TryAs<runtime::ClassInstance>();
+        if (instance_ptr->HasMethod(INIT_METHOD, args_.size()))
         {
             std::vector<ObjectHolder> args_values;
             for (const auto& argument : args_)
             {
                 args_values.push_back(std::move(argument->Execute(closure, context)));
             }
-            class_instance_.Call(INIT_METHOD, args_values, context);
+            instance_ptr->Call(INIT_METHOD, args_values, context);
         }
 
-        return runtime::ObjectHolder::Share(class_instance_);
+        return instance;
     }
 
-    ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
+    ObjectHolder MethodBody::Execute(Closure& closure, Context& context) const {
         if (!body_)
         {
             return runtime::ObjectHolder::None();
@@ -366,11 +744,35 @@ namespace ast {
         }
         catch (ReturnException& rex) 
         {
+            if (runtime::Statistics* statistics = context.GetStatistics())
+            {
+                statistics->NoteReturn();
+            }
             return rex.GetValue();
         }
         return runtime::ObjectHolder::None();
     }
 
+    ObjectHolder CountedStatement::Execute(Closure& closure, Context& context) const {
+        // Время учитывается и при выходе из инструкции исключением
+        struct Timer {
+            LineCounter& counter;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            ~Timer()
+            {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                counter.count.fetch_add(1, std::memory_order_relaxed);
+                counter.nanoseconds.fetch_add(
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                    std::memory_order_relaxed);
+            }
+        };
+
+        Timer timer{counter_};
+        return statement_->Execute(closure, context);
+    }
+
     runtime::ObjectHolder ReturnException::GetValue()
     {
         return ret_value_;
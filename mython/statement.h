@@ -1,5 +1,6 @@
 #pragma once
 
+#include "line_counters.h"
 #include "runtime.h"
 
 #include <functional>
@@ -8,6 +9,9 @@ namespace ast {
 
     using Statement = runtime::Executable;
 
+    // Оптимизирующий проход по дереву (см. optimizer.h)
+    class Optimizer;
+
     // Выражение, возвращающее значение типа T,
     // используется как основа для создания констант
     template <typename T>
@@ -18,8 +22,14 @@ namespace ast {
         }
 
         runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
-            runtime::Context& /*context*/) override {
-            return runtime::ObjectHolder::Share(value_);
+            runtime::Context& /*context*/) const override {
+            // Объекты-значения неизменяемы, поэтому константу можно выдавать без копирования
+            // одновременно нескольким выполнениям программы
+            return runtime::ObjectHolder::Share(const_cast<T&>(value_));
+        }
+
+        [[nodiscard]] const T& GetValue() const {
+            return value_;
         }
 
     private:
@@ -47,7 +57,7 @@ namespace ast {
             :dotted_ids_(std::move(dotted_ids))
         {}
 
-        runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) const override;
     private:
         std::vector<std::string> dotted_ids_{};
     };
@@ -59,7 +69,9 @@ namespace ast {
             :var_(std::move(var)), rv_(std::move(rv))
         {}
 
-        runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) const override;
+
+        friend class Optimizer;
     private:
         std::string var_{};
         std::unique_ptr<Statement> rv_;
@@ -72,18 +84,69 @@ namespace ast {
             : object_(std::move(object)), field_name_(std::move(field_name)), rv_(std::move(rv))
         {}
 
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
     private:
         VariableValue object_;
         std::string field_name_;
         std::unique_ptr<Statement> rv_;
     };
 
+    // Создаёт новый список из значений выражений elements
+    class ListLiteral : public Statement {
+    public:
+        explicit ListLiteral(std::vector<std::unique_ptr<Statement>> elements)
+            : elements_(std::move(elements))
+        {}
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        std::vector<std::unique_ptr<Statement>> elements_;
+    };
+
+    // Создаёт новый словарь из пар выражений (ключ, значение)
+    class DictLiteral : public Statement {
+    public:
+        using Item = std::pair<std::unique_ptr<Statement>, std::unique_ptr<Statement>>;
+
+        explicit DictLiteral(std::vector<Item> items)
+            : items_(std::move(items))
+        {}
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        std::vector<Item> items_;
+    };
+
+    // Присваивает элементу списка или словаря object[index] значение выражения rv
+    class IndexAssignment : public Statement {
+    public:
+        IndexAssignment(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index,
+            std::unique_ptr<Statement> rv)
+            : object_(std::move(object)), index_(std::move(index)), rv_(std::move(rv))
+        {}
+
+        // Если object - не список и не словарь либо индекс списка - не число, выбрасывает runtime_error.
+        // Возвращает rv
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        std::unique_ptr<Statement> object_;
+        std::unique_ptr<Statement> index_;
+        std::unique_ptr<Statement> rv_;
+    };
+
     // Значение None
     class None : public Statement {
     public:
         runtime::ObjectHolder Execute([[maybe_unused]] runtime::Closure& closure,
-            [[maybe_unused]] runtime::Context& context) override {
+            [[maybe_unused]] runtime::Context& context) const override {
             return {};
         }
     };
@@ -107,8 +170,11 @@ namespace ast {
         static std::unique_ptr<Print> Variable(const std::string& name);
 
         // Во время выполнения команды print вывод должен осуществляться в поток, возвращаемый из
-        // context.GetOutputStream()
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        // context.GetOutputStream(): текстом либо, если в контексте задан RecordWriter, одной
+        // записью в двоичном формате
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
     private:
         std::vector<std::unique_ptr<Statement>> args_{};
     };
@@ -121,13 +187,36 @@ namespace ast {
             :object_(std::move(object)), method_(std::move(method)), args_(std::move(args))
         {}
 
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        // Вызывает метод у уже вычисленного объекта callable_object
+        runtime::ObjectHolder CallOn(const runtime::ObjectHolder& callable_object, runtime::Closure& closure,
+                                     runtime::Context& context) const;
+
+        friend class Optimizer;
+        friend class TailReturn;
     private:
         std::unique_ptr<Statement> object_;
         std::string method_;
         std::vector<std::unique_ptr<Statement>> args_{};
     };
 
+    // Вызывает функцию function с аргументами args. Функция определяется на этапе разбора программы
+    class FunctionCall : public Statement {
+    public:
+        FunctionCall(const runtime::Function& function, std::vector<std::unique_ptr<Statement>> args)
+            : function_(function), args_(std::move(args))
+        {}
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+        friend class TailReturn;
+    private:
+        const runtime::Function& function_;
+        std::vector<std::unique_ptr<Statement>> args_;
+    };
+
     /*
     Создаёт новый экземпляр класса class_, передавая его конструктору набор параметров args.
     Если в классе отсутствует метод __init__ с заданным количеством аргументов,
@@ -144,15 +233,18 @@ namespace ast {
     class NewInstance : public Statement {
     public:
         NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args)
-            : class_instance_(class_), args_(std::move(args))
+            : class_(class_), args_(std::move(args))
         {}
         explicit NewInstance(const runtime::Class& class_)
-            : class_instance_(class_)
+            : class_(class_)
         {}
-        // Возвращает объект, содержащий значение типа ClassInstance
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        // Возвращает объект, содержащий новый экземпляр ClassInstance. Каждое выполнение узла
+        // создаёт отдельный экземпляр, поэтому узел не хранит состояния между выполнениями
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
     private:
-        runtime::ClassInstance class_instance_;
+        const runtime::Class& class_;
         std::vector<std::unique_ptr<Statement>> args_{};
     };
 
@@ -164,6 +256,7 @@ namespace ast {
         {
         }
 
+        friend class Optimizer;
     protected:
         std::unique_ptr<Statement> argument_;
     };
@@ -172,7 +265,14 @@ namespace ast {
     class Stringify : public UnaryOperation {
     public:
         using UnaryOperation::UnaryOperation;
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    // Операция len, возвращающая длину списка, словаря или строки
+    class Len : public UnaryOperation {
+    public:
+        using UnaryOperation::UnaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Родительский класс Бинарная операция с аргументами lhs и rhs
@@ -182,6 +282,8 @@ namespace ast {
             lhs_(std::move(lhs)), rhs_(std::move(rhs))
         {
         }
+
+        friend class Optimizer;
     protected:
         std::unique_ptr<Statement> lhs_;
         std::unique_ptr<Statement> rhs_;
@@ -197,7 +299,7 @@ namespace ast {
         //  строка + строка
         //  объект1 + объ   ект2, если у объект1 - пользовательский класс с методом _add__(rhs)
         // В противном случае при вычислении выбрасывается runtime_error
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Возвращает результат вычитания аргументов lhs и rhs
@@ -208,7 +310,7 @@ namespace ast {
         // Поддерживается вычитание:
         //  число - число
         // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Возвращает результат умножения аргументов lhs и rhs
@@ -219,7 +321,7 @@ namespace ast {
         // Поддерживается умножение:
         //  число * число
         // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Возвращает результат деления lhs и rhs
@@ -231,7 +333,7 @@ namespace ast {
         //  число / число
         // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
         // Если rhs равен 0, выбрасывается исключение runtime_error
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Возвращает результат вычисления логической операции or над lhs и rhs
@@ -240,7 +342,7 @@ namespace ast {
         using BinaryOperation::BinaryOperation;
         // Значение аргумента rhs вычисляется, только если значение lhs
         // после приведения к Bool равно False
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Возвращает результат вычисления логической операции and над lhs и rhs
@@ -249,14 +351,38 @@ namespace ast {
         using BinaryOperation::BinaryOperation;
         // Значение аргумента rhs вычисляется, только если значение lhs
         // после приведения к Bool равно True
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Возвращает результат вычисления логической операции not над единственным аргументом операции
     class Not : public UnaryOperation {
     public:
         using UnaryOperation::UnaryOperation;
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    // Унарный минус: возвращает число, противоположное значению аргумента.
+    // Если аргумент - не число, выбрасывается исключение runtime_error
+    class Negate : public UnaryOperation {
+    public:
+        using UnaryOperation::UnaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    // Возвращает элемент списка или словаря lhs[rhs]. Если lhs - не список и не словарь,
+    // индекс выходит за границы списка либо ключ отсутствует в словаре, выбрасывает runtime_error
+    class Index : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    // Операция lhs in rhs. Возвращает Bool: есть ли ключ lhs в словаре rhs, равный lhs элемент
+    // в списке rhs или подстрока lhs в строке rhs. Для остальных типов выбрасывает runtime_error
+    class Contains : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     };
 
     // Составная инструкция (например: тело метода, содержимое ветки if, либо else)
@@ -275,8 +401,9 @@ namespace ast {
         void AddStatement(std::unique_ptr<Statement> stmt);
 
         // Последовательно выполняет добавленные инструкции. Возвращает None
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
 
+        friend class Optimizer;
     private:
         std::vector<std::unique_ptr<Statement>> statements_;
 
@@ -305,8 +432,9 @@ namespace ast {
         // Вычисляет инструкцию, переданную в качестве body.
         // Если внутри body была выполнена инструкция return, возвращает результат return
         // В противном случае возвращает None
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
 
+        friend class Optimizer;
     private:
         std::unique_ptr<Statement> body_;
     };
@@ -320,26 +448,67 @@ namespace ast {
 
         // Останавливает выполнение текущего метода. После выполнения инструкции return метод,
         // внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
 
+        friend class Optimizer;
     private:
         std::unique_ptr<Statement> statement_;
     };
 
+    /*
+    Инструкция return object.method(args) или return function(args) в теле метода или функции.
+    Вычисляет объект и аргументы вызова и завершает текущий метод, возвращая вместо результата
+    отложенный вызов runtime::TailCall. Сам вызов выполняет ClassInstance::Call или
+    runtime::CallFunction, не увеличивая глубину стека, поэтому хвостовая рекурсия вида
+    return self.count(n - 1) выполняется в постоянном объёме стека
+    */
+    class TailReturn : public Statement {
+    public:
+        explicit TailReturn(std::unique_ptr<MethodCall> call)
+            : call_(std::move(call))
+        {}
+        explicit TailReturn(std::unique_ptr<FunctionCall> call)
+            : function_call_(std::move(call))
+        {}
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        // Задан ровно один из вызовов
+        std::unique_ptr<MethodCall> call_;
+        std::unique_ptr<FunctionCall> function_call_;
+    };
+
     // Объявляет класс
     class ClassDefinition : public Statement {
     public:
-        // Гарантируется, что ObjectHolder содержит объект типа runtime::Class
-        explicit ClassDefinition(runtime::ObjectHolder cls)
-            : cls_(cls)
+        // Гарантируется, что ObjectHolder содержит объект типа runtime::Class. constructor - функция,
+        // через которую создают экземпляры вызовы класса, разобранные до его определения, или nullptr
+        explicit ClassDefinition(runtime::ObjectHolder cls, std::unique_ptr<runtime::Function> constructor = nullptr)
+            : cls_(cls), constructor_(std::move(constructor))
         {}
 
 
         // Создаёт внутри closure новый объект, совпадающий с именем класса и значением, переданным в
-        // конструктор
-        runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) override;
+        // конструктор. Сам узел при этом не меняется и может выполняться повторно
+        runtime::ObjectHolder Execute(runtime::Closure& closure, [[maybe_unused]] runtime::Context& context) const override;
     private:
         runtime::ObjectHolder cls_;
+        std::unique_ptr<runtime::Function> constructor_;
+    };
+
+    // Объявляет функцию. Вызовы функции связываются с ней при разборе программы, а выполнение узла
+    // лишь создаёт в closure переменную с именем функции, через которую её может вызвать Interpreter
+    class FunctionDefinition : public Statement {
+    public:
+        explicit FunctionDefinition(std::unique_ptr<runtime::Function> function)
+            : function_(std::move(function))
+        {}
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    private:
+        std::unique_ptr<runtime::Function> function_;
     };
 
     // Инструкция if <condition> <if_body> else <else_body>
@@ -350,13 +519,94 @@ namespace ast {
             : condition_(std::move(condition)), if_body_(std::move(if_body)), else_body_(std::move(else_body))
         {}
 
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
     private:
         std::unique_ptr<Statement> condition_;
         std::unique_ptr<Statement> if_body_;
         std::unique_ptr<Statement> else_body_;
     };
 
+    // Цикл while <condition>: <body>
+    class While : public Statement {
+    public:
+        While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body)
+            : condition_(std::move(condition)), body_(std::move(body))
+        {}
+
+        // Выполняет body, пока значение condition истинно. Инструкция break внутри body
+        // прерывает цикл, continue - переходит к следующей проверке условия. Возвращает None
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        std::unique_ptr<Statement> condition_;
+        std::unique_ptr<Statement> body_;
+    };
+
+    /*
+    Цикл for var in range(start, stop, step): body.
+    Переменная цикла хранится как int и превращается в runtime::Number только если тело цикла
+    её читает или присваивает (use_var == true). Иначе var получает значение один раз,
+    после завершения цикла.
+    Параметр step может быть равен nullptr, тогда шаг равен 1
+    */
+    class For : public Statement {
+    public:
+        For(std::string var, std::unique_ptr<Statement> start, std::unique_ptr<Statement> stop,
+            std::unique_ptr<Statement> step, std::unique_ptr<Statement> body, bool use_var)
+            : var_(std::move(var)), start_(std::move(start)), stop_(std::move(stop)), step_(std::move(step))
+            , body_(std::move(body)), use_var_(use_var)
+        {}
+
+        // Если start, stop или step - не числа, либо step равен 0, выбрасывает runtime_error.
+        // Инструкции break и continue работают так же, как в цикле while. Возвращает None
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        std::string var_;
+        std::unique_ptr<Statement> start_;
+        std::unique_ptr<Statement> stop_;
+        std::unique_ptr<Statement> step_;
+        std::unique_ptr<Statement> body_;
+        bool use_var_;
+    };
+
+    // Инструкция break: прерывает выполнение ближайшего цикла
+    class Break : public Statement {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    // Инструкция continue: переходит к следующей итерации ближайшего цикла
+    class Continue : public Statement {
+    public:
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    /*
+    Инструкция statement, выполнение которой отмечается в счётчике её строки (см. line_counters.h).
+    Парсер создаёт такие узлы, только если включён подсчёт выполнения строк, поэтому
+    обычные узлы не тратят на подсчёт ни времени, ни памяти
+    */
+    class CountedStatement : public Statement {
+    public:
+        CountedStatement(std::unique_ptr<Statement> statement, LineCounter& counter)
+            : statement_(std::move(statement)), counter_(counter)
+        {}
+
+        // Выполняет statement, увеличивает счётчик и добавляет к нему время выполнения, в том числе
+        // когда statement завершается исключением (return, break, ошибкой)
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+
+        friend class Optimizer;
+    private:
+        std::unique_ptr<Statement> statement_;
+        LineCounter& counter_;
+    };
+
     // Операция сравнения
     class Comparison : public BinaryOperation {
     public:
@@ -370,11 +620,30 @@ namespace ast {
 
         // Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
         // приведённый к типу runtime::Bool
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
     private:
         Comparator cmp_;
     };
 
+    // Операция сравнения с оператором Op, известным на этапе компиляции.
+    // В отличие от Comparison, не вызывает компаратор через std::function
+    template <runtime::CompareOp Op>
+    class CompareOperation : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        // Вычисляет значение выражений lhs и rhs и возвращает результат их сравнения,
+        // приведённый к типу runtime::Bool
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) const override;
+    };
+
+    // Исключения для инструкций break и continue, перехватываются циклом
+    class BreakException : public std::exception {
+    };
+
+    class ContinueException : public std::exception {
+    };
+
     //Класс эксепшенов для ретернов
     class ReturnException : public std::exception
     {
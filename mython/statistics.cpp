@@ -0,0 +1,103 @@
+#include "statistics.h"
+
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        constexpr string_view OBJECT_TYPE_NAMES[Statistics::OBJECT_TYPE_COUNT] = {
+            "other"sv, "number"sv, "string"sv, "bool"sv, "class"sv,
+            "class_instance"sv, "tail_call"sv, "list"sv, "dict"sv, "function"sv,
+        };
+    }  // namespace
+
+    void NoteAllocation(Statistics& statistics, ObjectType type) {
+        statistics.NoteAllocation(type);
+    }
+
+    Statistics::Statistics() = default;
+
+    Statistics::~Statistics() {
+        Stop();
+    }
+
+    void Statistics::Start(ostream& output) {
+        if (running_)
+        {
+            return;
+        }
+        if (current_statistics != nullptr)
+        {
+            throw runtime_error("Another statistics is already collected in this thread"s);
+        }
+        current_statistics = this;
+        output_ = &output;
+        output_buffer_ = make_unique<CountingBuffer>(output.rdbuf());
+        output.rdbuf(output_buffer_.get());
+        running_ = true;
+    }
+
+    void Statistics::Stop() {
+        if (!running_)
+        {
+            return;
+        }
+        output_->flush();
+        output_->rdbuf(output_buffer_->GetTarget());
+        output_bytes_ += output_buffer_->GetCount();
+        output_buffer_.reset();
+        output_ = nullptr;
+        current_statistics = nullptr;
+        running_ = false;
+    }
+
+    uint64_t Statistics::GetOutputBytes() const {
+        return output_bytes_ + (output_buffer_ ? output_buffer_->GetCount() : 0);
+    }
+
+    void Statistics::WriteJson(ostream& out) const {
+        out << "{\n  \"allocations\": {"sv;
+        uint64_t total = 0;
+        for (size_t i = 0; i < OBJECT_TYPE_COUNT; ++i)
+        {
+            out << (i == 0 ? ""sv : ", "sv) << '"' << OBJECT_TYPE_NAMES[i] << "\": "sv << allocations_[i];
+            total += allocations_[i];
+        }
+        out << ", \"total\": "sv << total << "},\n"sv;
+        out << "  \"method_calls\": "sv << method_calls_ << ",\n"sv;
+        out << "  \"function_calls\": "sv << function_calls_ << ",\n"sv;
+        out << "  \"tail_calls\": "sv << tail_calls_ << ",\n"sv;
+        out << "  \"return_exceptions\": "sv << return_exceptions_ << ",\n"sv;
+        out << "  \"peak_closure_size\": "sv << peak_closure_size_ << ",\n"sv;
+        out << "  \"peak_instance_fields\": "sv << peak_field_count_ << ",\n"sv;
+        out << "  \"output_bytes\": "sv << GetOutputBytes() << "\n}"sv << endl;
+    }
+
+    Statistics::CountingBuffer::int_type Statistics::CountingBuffer::overflow(int_type ch) {
+        if (traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            return traits_type::not_eof(ch);
+        }
+        const int_type result = target_->sputc(traits_type::to_char_type(ch));
+        if (!traits_type::eq_int_type(result, traits_type::eof()))
+        {
+            ++count_;
+        }
+        return result;
+    }
+
+    streamsize Statistics::CountingBuffer::xsputn(const char* s, streamsize count) {
+        const streamsize written = target_->sputn(s, count);
+        count_ += static_cast<uint64_t>(written);
+        return written;
+    }
+
+    int Statistics::CountingBuffer::sync() {
+        return target_->pubsync();
+    }
+
+}  // namespace runtime
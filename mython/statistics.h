@@ -0,0 +1,129 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <streambuf>
+
+namespace runtime {
+
+    /*
+     * Статистика выполнения программы Mython: число созданных объектов по типам, вызовов методов
+     * и функций, выброшенных ReturnException, наибольшие размеры Closure и наборов полей
+     * экземпляров классов, объём вывода.
+     *
+     * Вызовы, return, Closure и поля учитываются, пока статистика подключена к контексту
+     * (Context::SetStatistics). Созданные объекты и вывод в поток output учитываются между Start
+     * и Stop в потоке, вызвавшем Start. Когда статистика не подключена, интерпретатор
+     * лишь проверяет указатель на неё
+     */
+    class Statistics {
+    public:
+        static constexpr size_t OBJECT_TYPE_COUNT = static_cast<size_t>(ObjectType::Function) + 1;
+
+        Statistics();
+
+        Statistics(const Statistics&) = delete;
+        Statistics& operator=(const Statistics&) = delete;
+
+        ~Statistics();
+
+        // Начинает учёт объектов, созданных ObjectHolder::Own в текущем потоке, и байтов,
+        // записанных в output. В потоке может собираться только одна статистика
+        void Start(std::ostream& output);
+        void Stop();
+
+        void NoteAllocation(ObjectType type) {
+            ++allocations_[static_cast<size_t>(type)];
+        }
+        void NoteMethodCall() {
+            ++method_calls_;
+        }
+        void NoteFunctionCall() {
+            ++function_calls_;
+        }
+        void NoteTailCall() {
+            ++tail_calls_;
+        }
+        void NoteReturn() {
+            ++return_exceptions_;
+        }
+        // Отмечает размер Closure в конце выполнения метода, функции или программы.
+        // Переменные из Closure не удаляются, поэтому в этот момент её размер наибольший
+        void NoteClosureSize(size_t size) {
+            peak_closure_size_ = std::max(peak_closure_size_, size);
+        }
+        void NoteFieldCount(size_t count) {
+            peak_field_count_ = std::max(peak_field_count_, count);
+        }
+
+        [[nodiscard]] uint64_t GetAllocations(ObjectType type) const {
+            return allocations_[static_cast<size_t>(type)];
+        }
+        [[nodiscard]] uint64_t GetMethodCalls() const {
+            return method_calls_;
+        }
+        [[nodiscard]] uint64_t GetFunctionCalls() const {
+            return function_calls_;
+        }
+        [[nodiscard]] uint64_t GetTailCalls() const {
+            return tail_calls_;
+        }
+        [[nodiscard]] uint64_t GetReturnExceptions() const {
+            return return_exceptions_;
+        }
+        [[nodiscard]] size_t GetPeakClosureSize() const {
+            return peak_closure_size_;
+        }
+        [[nodiscard]] size_t GetPeakFieldCount() const {
+            return peak_field_count_;
+        }
+        [[nodiscard]] uint64_t GetOutputBytes() const;
+
+        // Выводит статистику одним объектом JSON
+        void WriteJson(std::ostream& out) const;
+
+    private:
+        // Буфер потока вывода, подсчитывающий записанные байты и передающий их исходному буферу
+        class CountingBuffer : public std::streambuf {
+        public:
+            explicit CountingBuffer(std::streambuf* target)
+                : target_(target) {
+            }
+
+            [[nodiscard]] std::streambuf* GetTarget() const {
+                return target_;
+            }
+            [[nodiscard]] uint64_t GetCount() const {
+                return count_;
+            }
+
+        protected:
+            int_type overflow(int_type ch) override;
+            std::streamsize xsputn(const char* s, std::streamsize count) override;
+            int sync() override;
+
+        private:
+            std::streambuf* target_;
+            uint64_t count_ = 0;
+        };
+
+        std::array<uint64_t, OBJECT_TYPE_COUNT> allocations_{};
+        uint64_t method_calls_ = 0;
+        uint64_t function_calls_ = 0;
+        uint64_t tail_calls_ = 0;
+        uint64_t return_exceptions_ = 0;
+        size_t peak_closure_size_ = 0;
+        size_t peak_field_count_ = 0;
+
+        std::ostream* output_ = nullptr;
+        std::unique_ptr<CountingBuffer> output_buffer_;
+        uint64_t output_bytes_ = 0;
+        bool running_ = false;
+    };
+
+}  // namespace runtime
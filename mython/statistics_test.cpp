@@ -0,0 +1,100 @@
+#include "interpreter.h"
+#include "statistics.h"
+#include "test_runner.h"
+
+#include <sstream>
+
+using namespace std;
+using runtime::ObjectHolder;
+using runtime::ObjectType;
+
+namespace {
+
+void TestCounters() {
+    ostringstream output;
+    runtime::Statistics statistics;
+    Interpreter interpreter(output);
+    interpreter.GetContext().SetStatistics(&statistics);
+    statistics.Start(output);
+
+    istringstream program(R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+    self.label = 'p'
+
+  def sum():
+    return self.x + self.y
+
+def count(n):
+  if n == 0:
+    return 0
+  return count(n - 1)
+
+total = 0
+for i in range(3):
+  p = Point(i, 5000)
+  total = total + p.sum()
+print total, count(4), [1, 2]
+)");
+    interpreter.Load(program);
+    statistics.Stop();
+
+    ASSERT_EQUAL(output.str(), "15003 0 [1, 2]\n"s);
+    ASSERT_EQUAL(statistics.GetAllocations(ObjectType::ClassInstance), 3u);
+    ASSERT_EQUAL(statistics.GetAllocations(ObjectType::List), 1u);
+    ASSERT_EQUAL(statistics.GetAllocations(ObjectType::Class), 1u);
+    // 5000 + i не попадает в кэш малых чисел, как и промежуточные суммы
+    ASSERT(statistics.GetAllocations(ObjectType::Number) >= 6u);
+    ASSERT_EQUAL(statistics.GetMethodCalls(), 6u);
+    ASSERT_EQUAL(statistics.GetFunctionCalls(), 1u);
+    ASSERT_EQUAL(statistics.GetTailCalls(), 4u);
+    // sum трижды, count пять раз
+    ASSERT_EQUAL(statistics.GetReturnExceptions(), 8u);
+    // Глобальные переменные Point, count, total, i и p
+    ASSERT_EQUAL(statistics.GetPeakClosureSize(), 5u);
+    ASSERT_EQUAL(statistics.GetPeakFieldCount(), 3u);
+    ASSERT_EQUAL(statistics.GetOutputBytes(), output.str().size());
+
+    // Вывод после Stop не учитывается
+    output << "more"sv;
+    ASSERT_EQUAL(statistics.GetOutputBytes(), 15u);
+
+    ostringstream json;
+    statistics.WriteJson(json);
+    ASSERT(json.str().find("\"class_instance\": 3"s) != string::npos);
+    ASSERT(json.str().find("\"method_calls\": 6,"s) != string::npos);
+    ASSERT(json.str().find("\"output_bytes\": 15\n}"s) != string::npos);
+}
+
+void TestDisabledByDefault() {
+    ostringstream output;
+    runtime::Statistics statistics;
+    Interpreter interpreter(output);
+
+    istringstream program("x = [1]\nprint x\n"s);
+    interpreter.Load(program);
+
+    ASSERT_EQUAL(statistics.GetAllocations(ObjectType::List), 0u);
+    ASSERT_EQUAL(statistics.GetOutputBytes(), 0u);
+}
+
+void TestOneStatisticsPerThread() {
+    ostringstream output;
+    runtime::Statistics first;
+    runtime::Statistics second;
+    first.Start(output);
+    ASSERT_THROWS(second.Start(output), runtime_error);
+    first.Stop();
+    second.Start(output);
+    second.Stop();
+}
+
+}  // namespace
+
+void RunStatisticsTests(TestRunner& tr) {
+    RUN_TEST(tr, TestCounters);
+    RUN_TEST(tr, TestDisabledByDefault);
+    RUN_TEST(tr, TestOneStatisticsPerThread);
+}
@@ -163,4 +163,4 @@ private:
                                " " FILE_NAME ":"                \
                             << __LINE__;                        \
         Assert(false, __assert_private_os.str());               \
-    }
\ No newline at end of file
+    }
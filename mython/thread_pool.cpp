@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Пул и номер очереди текущего рабочего потока, чтобы Submit из задачи добавлял
+// в свою очередь
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = max<size_t>(thread_count, 1);
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(make_unique<WorkerQueue>());
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this, i] {
+            WorkerLoop(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Wait();
+    {
+        lock_guard lock(idle_mutex_);
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(function<void()> task) {
+    const size_t index = current_pool == this ? current_queue
+                                              : next_queue_.fetch_add(1, memory_order_relaxed) % queues_.size();
+    unfinished_.fetch_add(1);
+    {
+        lock_guard lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+    // Засыпающий поток увеличивает sleeping_ до проверки queued_, а здесь порядок обратный,
+    // поэтому либо он увидит новую задачу, либо мы увидим его и разбудим
+    if (sleeping_.load() > 0) {
+        lock_guard lock(idle_mutex_);
+        task_available_.notify_one();
+    }
+}
+
+void ThreadPool::Wait() {
+    unique_lock lock(done_mutex_);
+    all_done_.wait(lock, [this] {
+        return unfinished_.load() == 0;
+    });
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+size_t ThreadPool::GetStolenCount() const {
+    return stolen_.load(memory_order_relaxed);
+}
+
+optional<function<void()>> ThreadPool::TakeTask(size_t index) {
+    {
+        WorkerQueue& own = *queues_[index];
+        lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            auto task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return task;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        WorkerQueue& victim = *queues_[(index + i) % queues_.size()];
+        lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            auto task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_.fetch_sub(1);
+            stolen_.fetch_add(1, memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullopt;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    current_pool = this;
+    current_queue = index;
+
+    while (true) {
+        if (optional<function<void()>> task = TakeTask(index)) {
+            (*task)();
+            if (unfinished_.fetch_sub(1) == 1) {
+                lock_guard lock(done_mutex_);
+                all_done_.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock lock(idle_mutex_);
+        sleeping_.fetch_add(1);
+        task_available_.wait(lock, [this] {
+            return stopping_ || queued_.load() > 0;
+        });
+        sleeping_.fetch_sub(1);
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
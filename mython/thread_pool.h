@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/*
+ * Пул потоков фиксированного размера с перехватом задач (work stealing).
+ * У каждого рабочего потока своя очередь: задачи, добавленные из рабочего потока, попадают
+ * в его очередь, остальные распределяются по очередям по кругу. Поток берёт задачи из конца
+ * своей очереди, а опустев, забирает задачи из начала чужих очередей. Каждая очередь защищена
+ * своим мьютексом, а общие счётчики атомарны, поэтому добавление и взятие задач не проходят
+ * через общую блокировку. Поток, не нашедший задач ни в одной очереди, засыпает до появления новой
+ */
+class ThreadPool {
+public:
+    // Запускает thread_count рабочих потоков (не меньше одного)
+    explicit ThreadPool(size_t thread_count);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Дожидается выполнения всех задач и останавливает рабочие потоки
+    ~ThreadPool();
+
+    // Добавляет задачу в очередь. Задача не должна выбрасывать исключений
+    void Submit(std::function<void()> task);
+
+    // Блокирует вызывающий поток, пока не будут выполнены все добавленные задачи
+    void Wait();
+
+    [[nodiscard]] size_t GetThreadCount() const;
+
+    // Число задач, которые рабочие потоки забрали из чужих очередей
+    [[nodiscard]] size_t GetStolenCount() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void WorkerLoop(size_t index);
+    std::optional<std::function<void()>> TakeTask(size_t index);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<size_t> next_queue_ = 0;
+    std::atomic<size_t> stolen_ = 0;
+    // Число задач в очередях
+    std::atomic<size_t> queued_ = 0;
+    // Число задач в очередях и выполняемых в данный момент
+    std::atomic<size_t> unfinished_ = 0;
+
+    // На idle_mutex_ засыпают потоки, не нашедшие задач. Submit будит их, только если
+    // sleeping_ не 0, и не берёт мьютекс, пока все потоки заняты
+    std::mutex idle_mutex_;
+    std::condition_variable task_available_;
+    std::atomic<size_t> sleeping_ = 0;
+    // Защищён idle_mutex_
+    bool stopping_ = false;
+
+    // На done_mutex_ ждёт Wait
+    std::mutex done_mutex_;
+    std::condition_variable all_done_;
+
+    std::vector<std::thread> workers_;
+};